@@ -0,0 +1,381 @@
+#include <SDL3/SDL.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "circle_batch.h"
+#include "enemy.h"
+#include "enemy_simd.h"
+#include "globals.h"
+#include "job_pool.h"
+#include "rope_registry.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "utils.h"
+#include "world.h"
+
+using namespace std;
+
+#define FRAME_BUDGET_NS 16000000.0
+#define MIN_ITERATIONS 3
+
+typedef struct {
+  string phase;
+  int entities;
+  int iterations;
+  double ns_per_frame;
+} BenchResult;
+
+static vector<BenchResult> results;
+static double min_time_ns = 200.0 * 1e6;
+static vector<int> thread_counts;
+
+// Runs fn until min_time_ns has elapsed (and at least MIN_ITERATIONS times)
+// and records the mean time of one call as one frame's worth of that phase.
+template <typename F>
+static void measure(const string &phase, int entities, F &&fn) {
+  fn(); // warm up caches and let vectors reach their working size
+
+  Uint64 freq = SDL_GetPerformanceFrequency();
+  Uint64 start = SDL_GetPerformanceCounter();
+  Uint64 elapsed = 0;
+  int iterations = 0;
+  while (iterations < MIN_ITERATIONS ||
+         elapsed * 1e9 / freq < min_time_ns) {
+    fn();
+    iterations++;
+    elapsed = SDL_GetPerformanceCounter() - start;
+  }
+
+  BenchResult r;
+  r.phase = phase;
+  r.entities = entities;
+  r.iterations = iterations;
+  r.ns_per_frame = elapsed * 1e9 / freq / iterations;
+  results.push_back(r);
+
+  printf("%-44s %8d %10d %14.0f %12.2f %12.1f %8.1f%%\n", phase.c_str(),
+         entities, iterations, r.ns_per_frame, r.ns_per_frame / entities,
+         1e9 / r.ns_per_frame, 100.0 * r.ns_per_frame / FRAME_BUDGET_NS);
+}
+
+// Scatters n enemies above the floor at roughly one enemy per grid cell, so
+// neighbour collision sees a realistic density at every count.
+static void populate(EnemySystem &enemies, int n, Uint64 &seed) {
+  float side = sqrtf(n * 16.0f * gGS.enemy_radius * gGS.enemy_radius);
+  vector<float> x(n), y(n);
+  for (int i = 0; i < n; i++) {
+    x[i] = gGS.winW / 2.0f + (SDL_randf_r(&seed) - 0.5f) * side;
+    y[i] = gGS.winH - FLOOR_HEIGHT - SDL_randf_r(&seed) * side;
+  }
+  enemies.set_capacity(n);
+  enemies.spawn_many(EnemyType::Base, x.data(), y.data(), n);
+}
+
+static void bench_rope() {
+  for (int t = 0; t < rope_type_count(); t++) {
+    AnyRope any;
+    make_rope(any, t);
+    std::visit(
+        [&](auto &rope) {
+          string prefix = string("rope.") + rope.name;
+          measure(prefix + ".solve_physics", rope.points,
+                  [&] { rope.solve_physics(); });
+
+          for (int s = ROPE_SOLVER_LEGACY; s <= ROPE_SOLVER_DIRECT; s++) {
+            rope.set_solver((RopeSolver)s);
+            string name = prefix + ".solve_constraints." +
+                          rope_solver_name((RopeSolver)s);
+
+            gGS.isDragging = true;
+            measure(name + ".fwd", rope.points,
+                    [&] { rope.solve_constraints(); });
+
+            gGS.isDragging = false;
+            measure(name + ".bwd", rope.points,
+                    [&] { rope.solve_constraints(); });
+          }
+        },
+        any);
+  }
+}
+
+// n ropes of each registered type scattered over the screen, half of them
+// dragged towards a point that circles their start, stepped and drawn as one
+// RopeSystem.
+template <size_t... I>
+static void bench_rope_systems(int n, SDL_Renderer *renderer,
+                               index_sequence<I...>) {
+  auto run = [&](auto &&system) {
+    Uint64 seed = 1234;
+    vector<SDL_FPoint> start(n);
+    system.set_capacity(n);
+    for (int r = 0; r < n; r++) {
+      start[r] = {SDL_randf_r(&seed) * gGS.winW,
+                  SDL_randf_r(&seed) * gGS.winH};
+      system.add(start[r].x, start[r].y);
+    }
+
+    string prefix = string("ropes.") + system.name;
+    int frame = 0;
+    measure(prefix + ".update", n, [&] {
+      float angle = frame++ * DT;
+      for (int r = 0; r < n; r++) {
+        SDL_FPoint target = {start[r].x + 50.0f * cosf(angle + r),
+                             start[r].y + 50.0f * sinf(angle + r)};
+        system.set_target(r, target, r % 2 == 0);
+      }
+      system.update();
+    });
+    if (renderer) {
+      Camera camera;
+      measure(prefix + ".draw", n, [&] { system.draw(renderer, camera, 1.0f); });
+    }
+  };
+  (run(RopeSystem<typename variant_alternative_t<I, AnyRope>::Type>()), ...);
+}
+
+// Every phase starts from a freshly set up world, so one phase's effect on
+// the state (integration pulling everything onto the rope) doesn't skew the
+// numbers of the next.
+template <typename Setup>
+static bool bench_enemy_phases(Setup &&setup, SDL_Renderer *renderer) {
+  bool ok = true;
+  int n = 0;
+  auto phase = [&](const string &name, auto &&fn) {
+    Simulation sim(1234);
+    if (!setup(sim)) {
+      ok = false;
+      return;
+    }
+    // keep the population fixed across iterations of update()
+    sim.get_enemy_system().set_lifetime(0.0f);
+    sim.get_enemy_system().set_despawn_distance(0.0f);
+    n = sim.get_enemy_system().get_count();
+    sim.get_enemy_system().rebuild_grid();
+    measure(name, n, [&] { fn(sim); });
+  };
+  auto rope_points = [](Simulation &sim) {
+    return sim.visit_rope([](auto &rope) { return rope.get_points(); });
+  };
+
+  // the plain phases are single threaded; thread_counts adds .tN variants of
+  // the ones that use the job pool
+  job_pool_set_threads(1);
+  for (int level = SIMD_SCALAR; level <= simd_detect(); level++) {
+    simd_set_level((SimdLevel)level);
+    phase(string("enemy.integrate.") + simd_level_name((SimdLevel)level),
+          [&](Simulation &sim) {
+            sim.get_enemy_system().integrate(rope_points(sim));
+          });
+  }
+  simd_set_level(SIMD_AUTO);
+  phase("enemy.rebuild_grid",
+        [](Simulation &sim) { sim.get_enemy_system().rebuild_grid(); });
+  phase("enemy.collide_rope", [&](Simulation &sim) {
+    sim.get_enemy_system().collide_rope(rope_points(sim));
+  });
+  phase("enemy.collide_enemies",
+        [](Simulation &sim) { sim.get_enemy_system().collide_enemies(); });
+  Uint64 update_seed = 1234;
+  phase("enemy.update", [&](Simulation &sim) {
+    sim.get_enemy_system().update(sim.get_camera(), update_seed,
+                                  rope_points(sim));
+  });
+
+  phase("enemy.cull",
+        [](Simulation &sim) { sim.get_enemy_system().cull(sim.get_camera()); });
+  if (renderer) {
+    phase("enemy.draw", [&](Simulation &sim) {
+      sim.get_enemy_system().draw(renderer, sim.get_camera(), 1.0f);
+    });
+  }
+
+  for (int threads : thread_counts) {
+    job_pool_set_threads(threads);
+    string suffix = ".t" + to_string(threads);
+    phase("enemy.integrate" + suffix, [&](Simulation &sim) {
+      sim.get_enemy_system().integrate(rope_points(sim));
+    });
+    phase("enemy.collide_enemies" + suffix,
+          [](Simulation &sim) { sim.get_enemy_system().collide_enemies(); });
+    phase("enemy.update" + suffix, [&](Simulation &sim) {
+      sim.get_enemy_system().update(sim.get_camera(), update_seed,
+                                    rope_points(sim));
+    });
+  }
+  job_pool_set_threads(1);
+
+  if (!ok || !renderer)
+    return ok;
+
+  Uint64 seed = 1234;
+  vector<SDL_Point> centers(n);
+  for (int i = 0; i < n; i++) {
+    centers[i] = {(int)(SDL_randf_r(&seed) * gGS.winW),
+                  (int)(SDL_randf_r(&seed) * gGS.winH)};
+  }
+  measure("draw_circle", n, [&] {
+    for (int i = 0; i < n; i++)
+      draw_circle(renderer, centers[i].x, centers[i].y,
+                  (int)gGS.enemy_radius);
+  });
+
+  CircleBatch batch;
+  SDL_FColor color = get_draw_color(renderer);
+  measure("circle_batch", n, [&] {
+    for (int i = 0; i < n; i++)
+      batch.add(centers[i].x, centers[i].y, (int)gGS.enemy_radius, color);
+    batch.draw(renderer);
+  });
+  return true;
+}
+
+static void bench_enemies(int n, SDL_Renderer *renderer) {
+  bench_enemy_phases(
+      [n](Simulation &sim) {
+        Uint64 seed = 1234;
+        populate(sim.get_enemy_system(), n, seed);
+        return true;
+      },
+      renderer);
+}
+
+// Runs the enemy phases on a saved late-game world instead of a synthetic
+// scatter.
+static bool bench_snapshot(const char *path, SDL_Renderer *renderer) {
+  return bench_enemy_phases(
+      [path](Simulation &sim) { return load_snapshot(path, sim); }, renderer);
+}
+
+// Draws the six parallax layers, loose files or assets.slpak from the
+// working directory, once with the camera at rest and once high enough
+// that the near layers have scrolled off the bottom.
+static void bench_background(SDL_Renderer *renderer) {
+  if (!renderer)
+    return;
+  AssetPack pack;
+  AssetLoader assets(ASSET_LOADER_THREADS);
+  if (SDL_GetPathInfo(PACK_DEFAULT_PATH, nullptr) &&
+      pack.open(PACK_DEFAULT_PATH))
+    assets.mount(&pack);
+  Background bg(assets);
+  while (assets.busy())
+    assets.upload(renderer, ASSET_UPLOAD_BUDGET);
+
+  Camera camera;
+  measure("background.draw", 6, [&] { bg.draw(renderer, camera); });
+  SDL_FPoint high = {0.0f, gGS.winH / 2.0f - 4.0f * gGS.winH};
+  for (int k = 0; k < 100; k++)
+    camera.update(high, high);
+  measure("background.draw.high", 6, [&] { bg.draw(renderer, camera); });
+}
+
+static bool write_json(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    SDL_Log("Failed to open %s for writing", path);
+    return false;
+  }
+
+  fprintf(f, "{\n  \"frame_budget_ns\": %.0f,\n  \"results\": [\n",
+          FRAME_BUDGET_NS);
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchResult &r = results[i];
+    fprintf(f,
+            "    {\"phase\": \"%s\", \"entities\": %d, \"iterations\": %d, "
+            "\"ns_per_frame\": %.1f, \"ns_per_entity\": %.3f, "
+            "\"frames_per_sec\": %.2f}%s\n",
+            r.phase.c_str(), r.entities, r.iterations, r.ns_per_frame,
+            r.ns_per_frame / r.entities, 1e9 / r.ns_per_frame,
+            i + 1 < results.size() ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+  fclose(f);
+  return true;
+}
+
+static vector<int> parse_counts(const char *list) {
+  vector<int> counts;
+  string s = list;
+  size_t start = 0;
+  while (start < s.size()) {
+    size_t end = s.find(',', start);
+    if (end == string::npos)
+      end = s.size();
+    int n = atoi(s.substr(start, end - start).c_str());
+    if (n > 0)
+      counts.push_back(n);
+    start = end + 1;
+  }
+  return counts;
+}
+
+int main(int argc, char **argv) {
+  const char *out_path = "bench_results.json";
+  vector<int> counts = {100, 1000, 10000, 100000};
+  const char *snapshot_path = nullptr;
+  bool draw = true;
+  int cores = SDL_GetNumLogicalCPUCores();
+  if (cores > 1)
+    thread_counts.push_back(cores);
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      out_path = argv[++i];
+    } else if (strcmp(argv[i], "--counts") == 0 && i + 1 < argc) {
+      counts = parse_counts(argv[++i]);
+    } else if (strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc) {
+      min_time_ns = atof(argv[++i]) * 1e6;
+    } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+      snapshot_path = argv[++i];
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      thread_counts = parse_counts(argv[++i]);
+    } else if (strcmp(argv[i], "--no-draw") == 0) {
+      draw = false;
+    } else {
+      SDL_Log("usage: %s [--out FILE] [--counts N,N,...] [--min-ms MS] "
+              "[--snapshot FILE] [--threads N,N,...] [--no-draw]",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  // draw_circle goes through the software renderer so it can run without a
+  // display; the per-call overhead it measures is the same.
+  SDL_Surface *target = nullptr;
+  SDL_Renderer *renderer = nullptr;
+  if (draw) {
+    target = SDL_CreateSurface(gGS.winW, gGS.winH, SDL_PIXELFORMAT_RGBA32);
+    if (target)
+      renderer = SDL_CreateSoftwareRenderer(target);
+    if (!renderer)
+      SDL_Log("Software renderer unavailable, skipping draw benchmarks: %s",
+              SDL_GetError());
+  }
+
+  printf("%-44s %8s %10s %14s %12s %12s %9s\n", "phase", "entities", "iters",
+         "ns/frame", "ns/entity", "frames/s", "budget");
+
+  bench_rope();
+  bench_background(renderer);
+  for (int n : {1, 16, 256, 1024})
+    bench_rope_systems(n, renderer,
+                       make_index_sequence<variant_size_v<AnyRope>>());
+  for (int n : counts)
+    bench_enemies(n, renderer);
+  if (snapshot_path && !bench_snapshot(snapshot_path, renderer))
+    return 1;
+
+  if (renderer)
+    SDL_DestroyRenderer(renderer);
+  if (target)
+    SDL_DestroySurface(target);
+
+  if (!write_json(out_path))
+    return 1;
+  SDL_Log("Wrote %s", out_path);
+  return 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#define SIMD_ALIGN 32 // one AVX register
+#define SIMD_WIDTH 8  // floats per AVX register
+
+// std::vector allocator that hands out SIMD_ALIGN-aligned storage, so SoA
+// arrays can be streamed through vector registers without split loads.
+template <typename T, size_t Align = SIMD_ALIGN> struct AlignedAllocator {
+  using value_type = T;
+
+  template <typename U> struct rebind {
+    using other = AlignedAllocator<U, Align>;
+  };
+
+  AlignedAllocator() = default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Align> &) noexcept {}
+
+  T *allocate(size_t n) {
+    void *p = SDL_aligned_alloc(Align, n * sizeof(T));
+    if (!p)
+      throw std::bad_alloc();
+    return static_cast<T *>(p);
+  }
+
+  void deallocate(T *p, size_t) noexcept { SDL_aligned_free(p); }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U, Align> &) const noexcept {
+    return true;
+  }
+};
+
+using FloatArray = std::vector<float, AlignedAllocator<float>>;
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pack.h"
+#include "tiled_image.h"
+
+using namespace std;
+
+#define ASSET_LOADER_THREADS 2
+// Pixel bytes turned into textures per frame; one full-size background
+// layer, so a cold start spreads the uploads over a few frames
+#define ASSET_UPLOAD_BUDGET (4u * 1024u * 1024u)
+
+typedef enum {
+  ASSET_PENDING, // queued or being decoded
+  ASSET_DECODED, // pixels in memory, waiting for upload()
+  ASSET_READY,
+  ASSET_FAILED,
+} AssetState;
+
+typedef enum {
+  ASSET_IMAGE,
+  ASSET_TILED_IMAGE,
+  ASSET_FONT,
+} AssetKind;
+
+typedef int AssetHandle;
+
+// Loads assets off the main thread. PNG decoding and font opening run on
+// the loader's own workers; only texture creation has to happen on the
+// render thread, in upload(), which is called once a frame and spends at
+// most a byte budget so a burst of finished images doesn't stall a frame.
+// Callers poll get_texture()/get_font() and draw a placeholder until they
+// return non-null. The loader owns everything it loads.
+// With a pack mounted, most of this collapses: pixel entries are already
+// decoded, so only the uploads remain.
+class AssetLoader {
+  typedef struct {
+    AssetKind kind;
+    string path;
+    float size; // font point size
+    int tile;   // tiled image tile size
+    atomic<int> state;
+    const PackEntry *entry; // set when the mounted pack has the file
+    SDL_Surface *surface;
+    SDL_Texture *texture;
+    TiledImage tiled;
+    TTF_Font *font;
+  } Asset;
+
+  // Asset storage only grows, and only on the main thread; workers reach
+  // their asset through the pointer in the queue
+  vector<unique_ptr<Asset>> assets;
+  size_t first_unready; // every asset before this one is ready or failed
+  AssetPack *pack; // optional, see mount()
+
+  mutex queue_lock;
+  condition_variable wake;
+  deque<function<void()>> queue; // decodes and run() jobs, oldest first
+  vector<thread> workers;
+  bool quit;
+
+  // FreeType faces share one library, which isn't safe to open from
+  // several threads at once
+  mutex font_lock;
+
+  AssetHandle add(AssetKind kind, const char *path, float size, int tile);
+  void decode(Asset &asset);
+  void worker_main();
+
+public:
+  AssetLoader(int threads);
+  ~AssetLoader();
+
+  // Assets loaded after this come from pack when it has them: images skip
+  // decoding and go straight to upload(), fonts open from the mapped bytes.
+  // The pack must stay open for as long as the loader does.
+  void mount(AssetPack *pack);
+
+  AssetHandle load_image(const char *path);
+  // Decodes the image and cuts it up with tile_image() on a worker, so
+  // packed images still get a trip through the queue.
+  AssetHandle load_tiled_image(const char *path, int tile);
+  // TTF_Init must have been called first
+  AssetHandle load_font(const char *path, float size);
+
+  // Runs job on a worker once everything queued before it has started.
+  // For streaming work that has nothing to upload, e.g. map chunks; busy()
+  // doesn't wait for it.
+  void run(function<void()> job);
+
+  // Creates textures for decoded images, oldest first, until budget bytes
+  // of pixels have been uploaded (always at least one). Render thread only.
+  void upload(SDL_Renderer *renderer, size_t budget = ASSET_UPLOAD_BUDGET);
+
+  AssetState get_state(AssetHandle handle);
+  // nullptr until the asset is ready
+  SDL_Texture *get_texture(AssetHandle handle);
+  const TiledImage *get_tiled_image(AssetHandle handle);
+  TTF_Font *get_font(AssetHandle handle);
+  // true while anything is still queued, decoding or waiting for upload
+  bool busy();
+};
@@ -5,6 +5,9 @@
 class Camera {
   SDL_FPoint pos;
   float speed;
+  // pos before the last update, for drawing between steps; not part of the
+  // simulation state
+  SDL_FPoint prev_pos;
 
 public:
   Camera();
@@ -14,9 +17,36 @@ public:
 
   SDL_FPoint screenToWorld(const SDL_FPoint &screen) const;
 
+  // worldToScreen for whole arrays of positions. The offset is worked out
+  // once, leaving a loop of independent adds the compiler vectorises. The
+  // indexed form transforms x[index[k]], y[index[k]] into out[k].
+  void world_to_screen(const float *x, const float *y, SDL_FPoint *out,
+                       int n) const;
+  void world_to_screen(const float *x, const float *y, const int *index,
+                       SDL_FPoint *out, int n) const;
+
+  // World-space rectangle currently on screen.
+  SDL_FRect get_view() const;
+  // Smallest rectangle holding the view at both the previous and current
+  // positions, i.e. everything interpolated() can put on screen.
+  SDL_FRect get_swept_view() const;
+
   SDL_FPoint get_pos();
 
-  SDL_FPoint rand_point_in_view();
+  // Uniform point inside the current view, drawn from the caller's RNG state
+  // (SDL_randf_r) so that spawns are reproducible from a seed.
+  SDL_FPoint rand_point_in_view(Uint64 &rng_state);
 
   void update(SDL_FPoint anchor, SDL_FPoint end);
+
+  // Copy of the camera placed alpha of the way from its previous position
+  // to its current one.
+  Camera interpolated(float alpha) const;
+  // Forgets the previous position, e.g. after a snapshot load.
+  void settle();
+
+  template <typename F> void for_each_field(F &&f) {
+    f("camera.pos", pos);
+    f("camera.speed", speed);
+  }
 };
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <vector>
+
+using namespace std;
+
+// Collects filled circles as triangle fans and submits them all with one
+// SDL_RenderGeometry call. The vertex and index buffers keep their capacity
+// between frames, so steady-state drawing doesn't allocate.
+class CircleBatch {
+  vector<SDL_Vertex> vertices;
+  vector<int> indices;
+  int count;
+
+  // unit circle for the most recently used segment count
+  vector<SDL_FPoint> unit;
+  int unit_segments;
+
+  void build_unit(int segments);
+
+public:
+  CircleBatch();
+  ~CircleBatch();
+
+  // Queues a circle covering the same pixels as draw_circle(centerX, centerY,
+  // radius) would.
+  void add(int32_t centerX, int32_t centerY, int32_t radius, SDL_FColor color);
+  void draw(SDL_Renderer *renderer);
+  void clear();
+  int get_count();
+};
+
+// Current render draw color as the float color SDL_RenderGeometry takes.
+SDL_FColor get_draw_color(SDL_Renderer *renderer);
@@ -1,53 +1,230 @@
 #pragma once
 
 #include <SDL3/SDL.h>
-#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
 #include <vector>
 
+#include "aligned.h"
 #include "camera.h"
+#include "circle_batch.h"
+#include "rope_system.h"
+#include "state_fields.h"
 
 using namespace std;
 
 enum class EnemyType { Base };
 
+#define GRID_MAX_CELLS_PER_ENEMY 4
+#define GRID_MIN_CELLS 4096
+// Positions are clamped to +-this before binning, so a runaway enemy can't
+// overflow a cell index; NaN bins as 0.
+#define GRID_MAX_COORD 1e7f
+
+static inline float grid_coord(float v) {
+  return std::isnan(v) ? 0.0f : std::clamp(v, -GRID_MAX_COORD, GRID_MAX_COORD);
+}
+
+// Dense uniform grid over the bounding box of all enemies, rebuilt every
+// frame with a two-pass counting sort: cell_index holds enemy indices grouped
+// by cell, and cell_start[c]..cell_start[c + 1] is cell c's range. Cells are
+// aligned to multiples of cell_size in world space. All buffers keep their
+// capacity between rebuilds.
 class EnemyGrid {
+  float base_cell_size;
   float cell_size;
-  unordered_map<uint64_t, vector<int>> grid;
+  int origin_cx, origin_cy;
+  int cols, rows;
+
+  vector<int> cell_start;
+  vector<int> cell_cursor;
+  vector<int> cell_index;
+  vector<int> enemy_cell;
 
 public:
   EnemyGrid(float enemy_radius);
   ~EnemyGrid();
 
-  void clear();
-  void add(float x, float y, int index);
+  void rebuild(const float *x, const float *y, int count);
+
   float get_cell_size() const;
+  int get_cols() const;
+  int get_rows() const;
 
-  unordered_map<uint64_t, vector<int>> &get_grid();
-  float get_cell_size();
+  // Grid column/row of a world position. May be outside [0, cols) x [0, rows)
+  // for positions that moved since the last rebuild.
+  int cell_x(float x) const {
+    return (int)SDL_floorf(grid_coord(x) / cell_size) - origin_cx;
+  }
+  int cell_y(float y) const {
+    return (int)SDL_floorf(grid_coord(y) / cell_size) - origin_cy;
+  }
+
+  const int *cell_begin(int cx, int cy) const {
+    return cell_index.data() + cell_start[cy * cols + cx];
+  }
+  const int *cell_end(int cx, int cy) const {
+    return cell_index.data() + cell_start[cy * cols + cx + 1];
+  }
+
+  // Clamped cell range covering a world-space box. Returns false if the box
+  // misses the grid entirely.
+  bool cell_range(float min_x, float min_y, float max_x, float max_y,
+                  int &cx0, int &cy0, int &cx1, int &cy1) const;
+};
+
+#define ROPE_COLLISION_ITERATIONS 8
+
+// The enemies on screen after a step, with their positions before and after
+// it so they can be drawn part way between. Holds copies, so a list can be
+// filled on one thread and drawn on another.
+class EnemyDrawList {
+  vector<float> x_prev, y_prev, x_curr, y_curr, radius;
+
+  // draw scratch: blended world positions and their screen positions
+  vector<float> draw_x, draw_y;
+  vector<SDL_FPoint> screen_pos;
+  CircleBatch circle_batch;
+
+  friend class EnemySystem;
+
+public:
+  int get_count();
+  // Draws every enemy alpha of the way from its previous position to its
+  // current one, in the render draw colour.
+  void draw(SDL_Renderer *renderer, Camera &camera, float alpha);
 };
 
+// Default hard cap on live enemies; storage for this many is allocated up
+// front so spawning never reallocates mid-frame.
+#define ENEMY_DEFAULT_CAPACITY 4096
+// Seconds an enemy lives before it despawns (0 = forever).
+#define ENEMY_DEFAULT_LIFETIME 0.0f
+// Enemies further than this from the camera centre despawn (0 = never).
+#define ENEMY_DEFAULT_DESPAWN_DISTANCE 0.0f
+
+// Work per job-pool chunk: enemies for integration (a multiple of
+// SIMD_WIDTH), grid cells for neighbour collision.
+#define ENEMY_INTEGRATE_GRAIN 2048
+#define ENEMY_COLLIDE_GRAIN 64
+
 class EnemySystem {
   int count;
   float timer;
   float spawn_time;
 
   EnemyGrid enemy_grid;
+  // set whenever enemies are added, removed, moved by integrate or loaded,
+  // cleared by rebuild_grid
+  bool grid_dirty;
+  float max_radius;
+  // largest max_vel, i.e. how far x_prev can be from where the grid put x_curr
+  float max_speed;
+
+  int capacity;
+  float lifetime;
+  float despawn_distance;
+  vector<int> kill_list;
+
+  // draw scratch: enemies overlapping the view
+  vector<int> visible;
+  EnemyDrawList draw_list;
 
+  // rope broadphase scratch: enemies near the rope this frame, deduplicated
+  // with a per-enemy frame stamp
+  vector<int> rope_candidates;
+  vector<int> rope_stamp;
+  int rope_frame;
+  // the rope's points gathered out of its RopeSystem for the narrowphase
+  vector<float> rope_x, rope_y;
+
+  // SoA storage, SIMD_ALIGN-aligned for the integration kernels
   vector<EnemyType> enemy_type;
-  vector<float> x_curr;
-  vector<float> y_curr;
-  vector<float> x_prev;
-  vector<float> y_prev;
-  vector<float> attraction;
-  vector<float> mass;
-  vector<float> radius;
-  vector<float> max_vel;
+  FloatArray x_curr;
+  FloatArray y_curr;
+  FloatArray x_prev;
+  FloatArray y_prev;
+  FloatArray attraction;
+  FloatArray mass;
+  FloatArray radius;
+  FloatArray max_vel;
+  FloatArray age;
+
+  void collide_cell(int cx, int cy);
+  void remove(int i);
+
+  // Calls f on every per-enemy array, i.e. every vector state field.
+  template <typename F> void for_each_array(F &&f) {
+    for_each_field([&](const char *, auto &field) {
+      using T = std::remove_reference_t<decltype(field)>;
+      if constexpr (FieldView<T>::resizable)
+        f(field);
+    });
+  }
 
 public:
   EnemySystem();
   ~EnemySystem();
 
-  void add(EnemyType type, float x, float y);
-  void update(Camera &camera, vector<float> &x_rope, vector<float> &y_rope);
-  void draw(SDL_Renderer *renderer, Camera &camera);
+  int get_count();
+  int get_capacity();
+
+  // Hard cap on live enemies, rounded up to a multiple of SIMD_WIDTH. Storage
+  // for all of them is reserved immediately.
+  void set_capacity(int max_enemies);
+  void set_lifetime(float seconds);
+  void set_despawn_distance(float distance);
+
+  // Returns false, adding nothing, when the system is at capacity or type
+  // isn't one it knows how to add.
+  bool add(EnemyType type, float x, float y);
+  // Adds up to n enemies at (x[k], y[k]); returns how many fit.
+  int spawn_many(EnemyType type, const float *x, const float *y, int n);
+
+  // Queues enemy i for removal at the start of the next update. Indices stay
+  // valid until then; afterwards enemies may have been reordered.
+  void kill(int i);
+
+  // update() runs these phases in order; they are public so the benchmark
+  // can time each one on its own. collide_rope uses the grid built by
+  // rebuild_grid as its broadphase. integrate and collide_enemies split their
+  // work across job_pool(); the result doesn't depend on the thread count.
+  // despawn removes killed, expired and far-away enemies.
+  void despawn(Camera &camera);
+  void spawn(Camera &camera, Uint64 &rng_state);
+  void integrate(const RopePoints &rope);
+  void rebuild_grid();
+  void collide_rope(const RopePoints &rope);
+  void collide_enemies();
+
+  void update(Camera &camera, Uint64 &rng_state, const RopePoints &rope);
+  // Recomputes what is derived from the state fields below; call after
+  // writing them directly, as a snapshot load does.
+  void resync();
+  // Indices of enemies that can show anywhere between the last two steps:
+  // the circle swept from its previous to its current position, against
+  // the camera's swept view. Only grid cells overlapping the view are
+  // visited, as long as the grid is current.
+  const vector<int> &cull(Camera &camera);
+  // Copies the enemies cull() keeps into out.
+  void capture(Camera &camera, EnemyDrawList &out);
+  // capture() into a list of its own, then draw it.
+  void draw(SDL_Renderer *renderer, Camera &camera, float alpha);
+
+  template <typename F> void for_each_field(F &&f) {
+    f("enemy.count", count);
+    f("enemy.timer", timer);
+    f("enemy.spawn_time", spawn_time);
+    f("enemy.enemy_type", enemy_type);
+    f("enemy.x_curr", x_curr);
+    f("enemy.y_curr", y_curr);
+    f("enemy.x_prev", x_prev);
+    f("enemy.y_prev", y_prev);
+    f("enemy.attraction", attraction);
+    f("enemy.mass", mass);
+    f("enemy.radius", radius);
+    f("enemy.max_vel", max_vel);
+    f("enemy.age", age);
+  }
 };
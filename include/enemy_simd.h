@@ -0,0 +1,36 @@
+#pragma once
+
+// Everything the enemy integration step reads and writes, as raw SoA
+// pointers so the same arguments feed every kernel.
+typedef struct {
+  float *x_curr;
+  float *y_curr;
+  float *x_prev;
+  float *y_prev;
+  const float *attraction;
+  const float *mass;
+  const float *max_vel;
+  float anchor_x, anchor_y;
+  float floor_y;
+} IntegrateArgs;
+
+// Integrates enemies [begin, end). Every kernel performs the same float
+// operations in the same order as the scalar one (no FMA), so results are
+// bit-identical whichever one runs.
+typedef void (*IntegrateKernel)(const IntegrateArgs &args, int begin, int end);
+
+typedef enum { SIMD_AUTO, SIMD_SCALAR, SIMD_SSE2, SIMD_AVX } SimdLevel;
+
+void integrate_scalar(const IntegrateArgs &args, int begin, int end);
+
+// Highest level this CPU and build support.
+SimdLevel simd_detect();
+
+// Kernel for a level, falling back to the best supported level below it.
+IntegrateKernel simd_integrate_kernel(SimdLevel level);
+
+const char *simd_level_name(SimdLevel level);
+
+// Level used by EnemySystem::integrate. SIMD_AUTO picks simd_detect().
+void simd_set_level(SimdLevel level);
+SimdLevel simd_get_level();
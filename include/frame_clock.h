@@ -0,0 +1,46 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Most fixed steps run in one frame after a stall; the rest of the backlog
+// is dropped, so the game slows down instead of spiralling
+#define MAX_CATCHUP_STEPS 5
+// The last stretch before a frame deadline is spun rather than slept, since
+// the OS sleep can overshoot by about a scheduler tick
+#define FRAME_SPIN_NS 1500000
+
+// Drives a fixed-timestep simulation from wall-clock time. advance() turns
+// the real time since the last frame into a number of steps of dt, keeping
+// the remainder for the next frame; get_alpha() is how far the remainder
+// is into the next step, for interpolating between the last two states.
+// wait() paces frames to an optional cap.
+class FrameClock {
+  Uint64 step_ns;
+  Uint64 last;
+  Uint64 accumulator;
+  Uint64 frame_ns; // 0 = unpaced
+  Uint64 next_frame;
+  int dropped;
+
+public:
+  FrameClock(float dt);
+
+  // 0 renders as fast as presenting allows
+  void set_max_fps(int fps);
+
+  // Steps to run this frame, at most MAX_CATCHUP_STEPS.
+  int advance();
+  float get_alpha();
+  // SDL_GetTicksNS() at which the last step advance() returned fell due;
+  // the state after that step belongs to this moment.
+  Uint64 get_step_time();
+  Uint64 get_step_ns();
+  // steps skipped by the catch-up cap so far
+  int get_dropped_steps();
+
+  // Sleeps until the next frame slot under the fps cap, spinning for the
+  // final FRAME_SPIN_NS.
+  void wait();
+  // Sleeps until the next step falls due, for a loop that only steps.
+  void wait_step();
+};
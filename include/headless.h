@@ -0,0 +1,20 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include "options.h"
+
+// Scripted mouse input for frame `frame`, in screen space. Alternates between
+// swinging the rope around the screen centre and releasing it so that both
+// the dragging and the free-flight paths of the solver are exercised.
+SDL_FPoint scripted_mouse(int frame, bool &dragging);
+
+class Simulation;
+
+// Steps sim `frames` times with scripted input and no timing or output.
+void fast_forward(Simulation &sim, int frames);
+
+// Steps a Simulation opts.frames times as fast as possible, without creating
+// a window or renderer, and prints per-frame and total simulation time.
+// opts is a copy because a replay's recorded settings replace its own.
+int run_headless(Options opts);
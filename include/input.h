@@ -0,0 +1,57 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <deque>
+#include <mutex>
+
+using namespace std;
+
+// Mouse samples kept between two steps; a stalled simulation drops the
+// oldest rather than growing without bound
+#define MOUSE_SAMPLE_CAPACITY 256
+// Latency measurements averaged for display
+#define LATENCY_HISTORY 64
+
+typedef struct {
+  Uint64 time; // SDL_GetTicksNS() clock, as on SDL event timestamps
+  float x, y;  // window pixels
+} MouseSample;
+
+// Buffers every mouse position the event loop sees, with the time the
+// event happened, so the simulation can follow the path the mouse took
+// between two steps rather than only where it was last. push() and
+// take_path() may be called from different threads.
+class MouseSampler {
+  mutex lock;
+  deque<MouseSample> samples; // after last, oldest first
+  MouseSample last;           // where the previous path ended
+
+public:
+  MouseSampler();
+
+  void push(Uint64 time, float x, float y);
+
+  // Fills out with window positions spaced evenly in time from where the
+  // previous path ended up to the mouse at until, or at the newest sample
+  // if that's sooner, and returns how many: one per sample in that span, at
+  // most n and at least 1. out[count - 1] is the end. input_time is set to
+  // the moment the path ends at, if anything new arrived since the last
+  // call.
+  int take_path(Uint64 until, SDL_FPoint *out, int n, Uint64 &input_time);
+};
+
+// Running average of input-to-present times.
+class LatencyMeter {
+  Uint64 history[LATENCY_HISTORY];
+  int count;
+  int next;
+
+public:
+  LatencyMeter();
+
+  // Input from input_time was first shown by a present that returned at
+  // shown_time.
+  void add(Uint64 input_time, Uint64 shown_time);
+  // Average over the last LATENCY_HISTORY, or -1 before the first.
+  float get_ms();
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+typedef function<void(int begin, int end)> JobRange;
+
+// Small work-stealing pool for data-parallel loops. parallel_for deals the
+// chunks of a range round-robin onto one queue per thread; every thread pops
+// from the back of its own queue and steals from the front of the others
+// when it runs dry. The calling thread owns queue 0 and works too, so a pool
+// of N threads starts N - 1 workers. Only one thread may call parallel_for
+// at a time.
+class JobPool {
+  typedef struct {
+    const JobRange *fn;
+    int begin;
+    int end;
+  } Job;
+
+  typedef struct {
+    mutex lock;
+    deque<Job> jobs;
+  } Queue;
+
+  vector<unique_ptr<Queue>> queues;
+  vector<thread> workers;
+
+  mutex sleep_lock;
+  condition_variable wake;
+  atomic<int> queued;  // jobs sitting in a queue
+  atomic<int> pending; // jobs not finished yet
+  bool quit;
+
+  bool pop(int self, Job &job);
+  void run(const Job &job);
+  void worker_main(int self);
+
+public:
+  JobPool(int threads);
+  ~JobPool();
+
+  int get_thread_count() const;
+
+  // Calls fn on disjoint chunks of at most grain items covering [begin, end)
+  // and returns once all of them have finished.
+  void parallel_for(int begin, int end, int grain, const JobRange &fn);
+};
+
+// Thread count used by job_pool(); 0 means one per logical core and 1 runs
+// everything on the calling thread. Takes effect on the next job_pool().
+void job_pool_set_threads(int threads);
+int job_pool_get_threads();
+
+// Shared pool, (re)created on demand with job_pool_get_threads() threads.
+JobPool &job_pool();
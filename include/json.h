@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+typedef enum {
+  JSON_NULL,
+  JSON_BOOL,
+  JSON_NUMBER,
+  JSON_STRING,
+  JSON_ARRAY,
+  JSON_OBJECT
+} JsonType;
+
+// Parsed JSON document, for the offline asset tools. Objects keep their
+// members in file order; lookups are linear, which is fine for the
+// handful of keys a Tiled map or tileset has.
+struct JsonValue {
+  JsonType type = JSON_NULL;
+  bool boolean = false;
+  double number = 0.0;
+  string str;
+  vector<JsonValue> items;
+  vector<pair<string, JsonValue>> members;
+
+  // Member named key, or nullptr if this isn't an object or has no such key.
+  const JsonValue *get(const char *key) const;
+  double get_number(const char *key, double fallback) const;
+  bool get_bool(const char *key, bool fallback) const;
+  const char *get_string(const char *key, const char *fallback) const;
+};
+
+// Parses text[0, len). On failure returns false and describes the problem,
+// with its line number, in error.
+bool json_parse(const char *text, size_t len, JsonValue &out, string &error);
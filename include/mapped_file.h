@@ -0,0 +1,26 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Read-only view of a whole file. Uses mmap where available so only the
+// pages that are actually touched get faulted in, and falls back to reading
+// the file into memory elsewhere.
+class MappedFile {
+  void *data;
+  size_t size;
+  bool mapped;
+
+public:
+  MappedFile();
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool open(const char *path);
+  void close();
+
+  const Uint8 *bytes() const;
+  size_t get_size() const;
+  // true when the bytes are the file's own pages rather than a copy
+  bool is_mapped() const;
+};
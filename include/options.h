@@ -0,0 +1,36 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include "rope_solver.h"
+
+typedef struct {
+  bool headless;
+  int frames; // 0 = default: 3600 scripted frames, or the whole replay
+  bool quiet;
+  bool seed_set;
+  Uint64 seed;
+  const char *record_path;
+  const char *replay_path;
+  const char *hash_log_path;
+  const char *hash_compare[2];
+  const char *snapshot_load_path;
+  const char *snapshot_save_path;
+  int fast_forward;
+  const char *simd;
+  int threads; // 0 = one per logical core
+  int max_enemies;
+  float enemy_lifetime; // seconds, 0 = forever
+  float despawn_distance; // from the camera centre, 0 = never
+  int rope_type; // index into AnyRope, see rope_registry.h
+  RopeSolver rope_solver;
+  const char *map_path; // cooked map, see slinger_cook
+  const char *pack_path; // nullptr: PACK_DEFAULT_PATH if it exists
+  bool vsync;
+  int max_fps; // 0 = uncapped
+  bool pipeline; // simulate on a thread of its own while rendering
+} Options;
+
+// Parses command line flags into opts. Returns false on unknown or malformed
+// flags after logging a usage message.
+bool parse_options(int argc, char **argv, Options &opts);
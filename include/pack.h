@@ -0,0 +1,72 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include "mapped_file.h"
+
+using namespace std;
+
+#define PACK_MAGIC 0x4b504c53u // "SLPK"
+#define PACK_VERSION 1u
+#define PACK_BYTE_ORDER 0x01020304u
+#define PACK_PATH_LEN 128
+#define PACK_ALIGN 4096 // entry data starts on a page boundary
+#define PACK_DEFAULT_PATH "assets.slpak"
+
+typedef enum {
+  PACK_ENTRY_PIXELS, // decoded image, ready for SDL_UpdateTexture
+  PACK_ENTRY_BYTES,  // file copied as is (fonts)
+} PackEntryKind;
+
+// Pack layout, native byte order (the header records it):
+//   PackHeader
+//   entry_count x PackEntry, sorted by path
+//   entry data, each entry starting on a PACK_ALIGN boundary
+// Entries are looked up by the same relative paths the game would open
+// loose, so a pack can stand in for the assets directory.
+typedef struct {
+  Uint32 magic;
+  Uint32 version;
+  Uint32 byte_order; // 0x01020304 as written by the cooking machine
+  Uint32 entry_count;
+  Uint64 file_size;
+} PackHeader;
+
+typedef struct {
+  char path[PACK_PATH_LEN];
+  Uint32 kind;   // PackEntryKind
+  Uint32 format; // SDL_PixelFormat of pixel entries
+  Uint32 w, h;
+  Uint32 pitch;
+  Uint32 reserved;
+  Uint64 offset;
+  Uint64 size;
+} PackEntry;
+
+// Offline step behind `slinger_cook pack`: decodes every .png input to
+// RGBA32 and stores everything else as plain bytes, under the path given.
+bool cook_asset_pack(const char *out_path, const char *const *inputs,
+                     int count);
+
+// A pack mapped into memory. Nothing is copied on open; pixel data goes
+// from the mapped pages straight into SDL_UpdateTexture.
+class AssetPack {
+  MappedFile file;
+  const PackEntry *entries;
+  Uint32 entry_count;
+
+public:
+  AssetPack();
+
+  bool open(const char *path);
+  void close();
+  bool is_open();
+
+  // nullptr if the pack has no entry for path
+  const PackEntry *find(const char *path);
+  const void *data(const PackEntry &entry);
+  // Creates a static texture from a pixel entry.
+  SDL_Texture *create_texture(SDL_Renderer *renderer, const PackEntry &entry);
+  // Read-only stream over an entry's bytes, e.g. for TTF_OpenFontIO.
+  SDL_IOStream *open_io(const PackEntry &entry);
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <atomic>
+
+#define PROFILER_RING_SIZE 16384
+#define PROFILER_FRAME_HISTORY 240
+
+typedef struct {
+  const char *name; // must outlive the profiler, i.e. a string literal
+  Uint64 start;     // performance counter ticks
+  Uint64 end;
+} ProfileSample;
+
+// Fixed-size ring of samples written by exactly one thread. The writer never
+// blocks; readers copy a window out and drop anything the writer may have
+// overwritten while they were copying. Every slot is a tiny seqlock: its
+// sequence number says which sample it holds, or 0 while it is being
+// written, and the reader keeps a slot only if the number is the one it
+// expects both before and after reading the fields.
+class ProfileRing {
+  typedef struct {
+    std::atomic<Uint64> seq; // sample index + 1, or 0 mid-write
+    std::atomic<const char *> name;
+    std::atomic<Uint64> start;
+    std::atomic<Uint64> end;
+  } Slot;
+
+  Slot slots[PROFILER_RING_SIZE];
+  std::atomic<Uint64> head;
+  int thread_id;
+
+public:
+  ProfileRing(int thread_id);
+
+  void push(const char *name, Uint64 start, Uint64 end);
+  int copy_out(ProfileSample *out, int max_samples) const;
+  int get_thread_id() const;
+};
+
+typedef struct {
+  float last_ms;
+  float p50_ms;
+  float p99_ms;
+  float max_ms;
+} FrameStats;
+
+// Records a finished zone into the calling thread's ring.
+void profiler_record(const char *name, Uint64 start, Uint64 end);
+
+// Marks the start of a new frame and stores the previous frame's duration.
+void profiler_frame_mark();
+
+// Copies the frame time history, oldest first, into out. Returns the count.
+int profiler_frame_history(float *out_ms, int max_frames);
+
+FrameStats profiler_frame_stats();
+
+// Writes every buffered sample from every thread as Chrome trace JSON
+// (chrome://tracing, Perfetto).
+bool profiler_dump_chrome_trace(const char *path);
+
+class ProfileZone {
+  const char *name;
+  Uint64 start;
+
+public:
+  ProfileZone(const char *name)
+      : name(name), start(SDL_GetPerformanceCounter()) {}
+  ~ProfileZone() { profiler_record(name, start, SDL_GetPerformanceCounter()); }
+};
+
+#ifdef SLINGER_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name)                                                     \
+  ProfileZone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_FRAME() profiler_frame_mark()
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
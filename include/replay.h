@@ -0,0 +1,78 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <vector>
+
+#include "options.h"
+#include "rope_system.h"
+
+using namespace std;
+
+#define REPLAY_MAGIC 0x50524c53u // "SLRP"
+#define REPLAY_VERSION 3u
+
+// Everything the simulation reads from the outside world in one frame.
+typedef struct {
+  AnchorPath mouseWorld; // the mouse through the frame, in world space
+  int winW, winH;
+  bool isDragging;
+} FrameInput;
+
+// The options a run depends on besides its input, kept with the recording.
+typedef struct {
+  int rope_type;
+  RopeSolver rope_solver;
+  int max_enemies;
+  float enemy_lifetime;
+  float despawn_distance;
+} ReplaySettings;
+
+// File layout, all little endian:
+//   u32 magic, u32 version, u64 seed, u32 winW, u32 winH,
+//   u32 rope_type, u32 rope_solver, u32 max_enemies, f32 enemy_lifetime,
+//   f32 despawn_distance, u32 frame_count
+//   frame_count x { u8 path_count, path_count x { f32 mouse_x, f32 mouse_y },
+//                   u16 winW, u16 winH, u8 flags }
+// Version 2 files, without the settings, and version 1 files, with one
+// mouse position per frame and no path_count either, still load.
+class InputRecorder {
+  SDL_IOStream *io;
+  Uint32 frame_count;
+
+public:
+  InputRecorder();
+  ~InputRecorder();
+
+  bool open(const char *path, Uint64 seed, const Options &opts);
+  void write(const FrameInput &input);
+  void close();
+};
+
+class InputReplay {
+  vector<FrameInput> frames;
+  Uint64 seed;
+  int start_w, start_h;
+  bool has_settings; // version 3 and up
+  ReplaySettings settings;
+  size_t cursor;
+
+public:
+  InputReplay();
+  ~InputReplay();
+
+  bool load(const char *path);
+  Uint64 get_seed();
+  int get_frame_count();
+  bool done();
+  const FrameInput &next();
+
+  // Sets the window size the recording started with, which Rope and the
+  // first spawns depend on, and puts the recorded settings into opts in
+  // place of the command line's. Call before constructing the Simulation.
+  void apply_start_state(Options &opts);
+};
+
+FrameInput capture_frame_input(const AnchorPath &mouseWorld);
+FrameInput capture_frame_input(SDL_FPoint mouseWorld);
+
+void apply_frame_input(const FrameInput &input);
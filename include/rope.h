@@ -1,23 +1,24 @@
 #pragma once
 
 #include <SDL3/SDL.h>
-#include <vector>
 
 #include "camera.h"
-#include "utils.h"
+#include "rope_system.h"
 
 using namespace std;
 
-class Rope {
-  vector<float> x_curr;
-  vector<float> y_curr;
-  vector<float> x_prev;
-  vector<float> y_prev;
-  vector<SDL_FPoint> screen_points;
-  vector<float> masses;
-  bool anchored = false;
-  int brightness = 0;
-  float end_speed;
+// The player's rope: a RopeSystem holding a single rope, steered by the mouse
+// and gGS.isDragging, so it runs the same batched solver path as every other
+// rope. RopeType supplies `static constexpr RopeConfig config` and a `name`.
+template <typename RopeType> class Rope {
+public:
+  typedef RopeType Type;
+  static constexpr RopeConfig config = RopeType::config;
+  static constexpr const char *name = RopeType::name;
+  static constexpr int points = config.points;
+
+private:
+  RopeSystem<RopeType> system;
 
 public:
   Rope();
@@ -26,13 +27,16 @@ public:
   SDL_FPoint get_anchor();
   float get_altitude();
   float get_speed();
-  vector<float> &get_x();
-  vector<float> &get_y();
-  void solve_collisions(float &y);
+  RopePoints get_points();
   void solve_physics();
-  void forward_constraints();
-  void backward_constraints();
   void solve_constraints();
+  void set_solver(RopeSolver solver);
+  RopeSolver get_solver();
   void update(SDL_FPoint mousePos);
-  void draw(SDL_Renderer *renderer, Camera &camera);
+  // update() with the anchor walked along path while dragging.
+  void update(const AnchorPath &path);
+  void capture(RopeDrawList &out);
+  void draw(SDL_Renderer *renderer, Camera &camera, float alpha);
+
+  template <typename F> void for_each_field(F &&f) { system.for_each_field(f); }
 };
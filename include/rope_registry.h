@@ -0,0 +1,47 @@
+#pragma once
+
+#include <variant>
+
+#include "rope.h"
+
+// The rope types the game can switch between at runtime. Each is a separate
+// Rope and RopeSystem instantiation (explicitly instantiated in rope.cpp and
+// rope_system.cpp); picking one only selects which alternative of AnyRope is
+// live, so the per-point loops never see a runtime size.
+
+struct DefaultRope {
+  static constexpr const char *name = "default";
+  static constexpr RopeConfig config = {
+      20, 10.0f, 40, 0.999f, 0.03f, 0.0005f, 10.0f, 1e-7f};
+};
+
+struct ShortStiffRope {
+  static constexpr const char *name = "short";
+  static constexpr RopeConfig config = {
+      12, 10.0f, 40, 0.999f, 0.03f, 0.0005f, 10.0f, 0.0f};
+};
+
+struct LongWhippyRope {
+  static constexpr const char *name = "long";
+  static constexpr RopeConfig config = {
+      40, 8.0f, 40, 0.9995f, 0.02f, 0.001f, 6.0f, 1e-5f};
+};
+
+extern template class RopeSystem<DefaultRope>;
+extern template class RopeSystem<ShortStiffRope>;
+extern template class RopeSystem<LongWhippyRope>;
+extern template class Rope<DefaultRope>;
+extern template class Rope<ShortStiffRope>;
+extern template class Rope<LongWhippyRope>;
+
+// Alternative order is the rope type index used by options and snapshots.
+typedef variant<Rope<DefaultRope>, Rope<ShortStiffRope>, Rope<LongWhippyRope>>
+    AnyRope;
+
+int rope_type_count();
+const char *rope_type_name(int type);
+// Looks a type up by rope_type_name; false if there is none.
+bool rope_type_from_name(const char *name, int &type);
+
+// Replaces rope with a fresh rope of the given type.
+void make_rope(AnyRope &rope, int type);
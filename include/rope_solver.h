@@ -0,0 +1,16 @@
+#pragma once
+
+// How solve_constraints enforces the segment lengths.
+//  LEGACY: RopeConfig::iterations Gauss-Seidel sweeps, forward while
+//          dragging and backward otherwise, with the ball nearly pinned
+//          (the default).
+//  XPBD:   ROPE_XPBD_ITERATIONS mass-weighted XPBD sweeps with compliance.
+//  DIRECT: ROPE_DIRECT_ITERATIONS Newton steps, each solving all distance
+//          constraints together as one tridiagonal system.
+// XPBD and DIRECT start with a long range attachment pass and weight every
+// correction by the inverse masses in masses.
+typedef enum { ROPE_SOLVER_LEGACY, ROPE_SOLVER_XPBD, ROPE_SOLVER_DIRECT } RopeSolver;
+
+const char *rope_solver_name(RopeSolver solver);
+// Looks a solver up by rope_solver_name; false if there is none.
+bool rope_solver_from_name(const char *name, RopeSolver &solver);
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <array>
+#include <vector>
+
+#include "aligned.h"
+#include "camera.h"
+#include "circle_batch.h"
+#include "rope_solver.h"
+#include "utils.h"
+
+using namespace std;
+
+// solver effort, see rope_solver.h
+#define ROPE_XPBD_ITERATIONS 10
+#define ROPE_DIRECT_ITERATIONS 4
+#define ROPE_DIRECT_BACKTRACKS 6
+
+// Most points a dragged anchor is walked through in one step
+#define ROPE_ANCHOR_SUBSTEPS 4
+
+// ropes stepped together, one per SSE2 lane
+#define ROPE_LANES 4
+#define ROPE_LINE_WIDTH 1.0f
+
+// Everything that shapes one kind of rope. RopeSystem is instantiated per
+// config, so all of it is a compile-time constant in the solver loops.
+typedef struct {
+  int points;
+  float spacing;    // rest length of each segment
+  int iterations;   // legacy Gauss-Seidel sweeps
+  float damping;    // velocity kept per step
+  float air_resistance;
+  float point_mass;
+  float ball_mass;  // the last point
+  float compliance; // m/N (inverse stiffness) for XPBD and DIRECT; 0 = rigid
+} RopeConfig;
+
+// Where a dragged anchor goes during one step: through points[0] to
+// points[count - 1], which is where it ends up. Samples of the input
+// between two steps, so a fast flick bends the rope along its whole arc
+// instead of jumping to where it stopped.
+typedef struct {
+  SDL_FPoint points[ROPE_ANCHOR_SUBSTEPS];
+  int count; // 1..ROPE_ANCHOR_SUBSTEPS
+} AnchorPath;
+
+// One rope's points inside a RopeSystem: point j is (x[j * stride],
+// y[j * stride]).
+typedef struct {
+  float *x;
+  float *y;
+  int points;
+  int stride;
+} RopePoints;
+
+template <typename RopeType> class RopeSystem;
+
+// Every rope of a RopeSystem as of its last step, with each point's position
+// before and after that step so they can be drawn part way between. Holds
+// copies, so a list can be filled on one thread and drawn on another.
+class RopeDrawList {
+  int count, points, stride;
+  vector<float> x_prev, y_prev, x_curr, y_curr; // laid out as in RopeSystem
+  vector<int> brightness;
+
+  // draw scratch
+  vector<float> draw_x, draw_y;
+  vector<SDL_FPoint> screen_points;
+  vector<SDL_Vertex> vertices;
+  vector<int> indices;
+  CircleBatch circle_batch;
+
+  template <typename RopeType> friend class RopeSystem;
+
+public:
+  RopeDrawList();
+
+  int get_count();
+  // All segments go out in one SDL_RenderGeometry call and all balls in one
+  // CircleBatch. Leaves the last rope's colour as the render draw colour.
+  // Points are drawn alpha of the way from their previous positions to
+  // their current ones.
+  void draw(SDL_Renderer *renderer, Camera &camera, float alpha);
+};
+
+// Many ropes of one RopeType, stepped together. Positions are stored point
+// by point with the ropes interleaved, so point i of rope r is at
+// [i * stride + r] and ROPE_LANES neighbouring ropes fill one vector
+// register: every solver loop walks the points of a rope in order, exactly
+// like the single-rope code did, but moves ROPE_LANES ropes per instruction.
+// Ropes left over once the rest fill groups of ROPE_LANES, such as the
+// game's single rope, are stepped one at a time on plain floats rather than
+// in a vector with idle lanes. Each lane sees the same float operations a
+// lone rope would, so a rope moves the same whichever lane it is in, or
+// none, and whatever its neighbours do.
+//
+// The last point of every rope is its ball. Rope r's first point follows the
+// target set with set_target while it is dragging.
+template <typename RopeType> class RopeSystem {
+public:
+  static constexpr RopeConfig config = RopeType::config;
+  static constexpr const char *name = RopeType::name;
+  static constexpr int points = config.points;
+
+private:
+  static constexpr int segments = points - 1;
+
+  int count;
+  int stride; // capacity, a multiple of ROPE_LANES
+  FloatArray x_curr, y_curr, x_prev, y_prev;
+  array<float, points> masses;
+  vector<Uint8> anchored;
+  FloatArray end_speed;
+  FloatArray filtered_speed;
+  RopeSolver solver;
+
+  // per-rope input for the next update; dragging is 1 or 0
+  FloatArray target_x, target_y, dragging;
+  // the anchor path before its target, at [k * stride + r] for substep k
+  FloatArray path_x, path_y;
+  vector<Uint8> anchor_substeps; // path points per rope, the target included
+
+  // per-rope colour, 0-255, set by update()
+  vector<int> brightness;
+
+  RopeDrawList draw_list;
+
+  void place(int r, float center_x, float center_y);
+  // sizes the input and colour arrays to stride, e.g. after a snapshot load
+  void fit_scratch();
+  // Moves the dragged anchors to substep k of their paths. Anchors still
+  // reeling in move only on the last one, and ropes whose paths are shorter
+  // than k are left where their last substep put them.
+  void follow_targets(int k);
+  void update_brightness();
+  // Steps the ropes of one block: ROPE_LANES of them from b with L = Lanes,
+  // or rope b alone with L = OneLane (see rope_system.cpp).
+  template <typename L> void physics_block(int b);
+  template <typename L> void constraints_block(int b);
+  template <typename L> void legacy_block(int b);
+  template <typename L> void xpbd_block(int b);
+  template <typename L> void direct_block(int b);
+
+public:
+  RopeSystem();
+  ~RopeSystem();
+
+  int get_count();
+  int get_capacity();
+  // Rounds up to a multiple of ROPE_LANES; never drops below the count.
+  void set_capacity(int n);
+  // Adds a horizontal rope centred on (x, y), growing the capacity if
+  // needed, and returns its index.
+  int add(float x, float y);
+
+  void set_target(int r, SDL_FPoint target, bool dragging);
+  // set_target, with the anchor walked through path on the way. Ropes may
+  // have paths of different lengths; all of them take as many constraint
+  // solves as the longest, and update() goes back to plain targets.
+  void set_target_path(int r, const AnchorPath &path, bool dragging);
+  RopePoints get_points(int r);
+  SDL_FPoint get_end(int r);
+  SDL_FPoint get_anchor(int r);
+  // Smoothed speed of rope r's ball; call once per step.
+  float get_speed(int r);
+
+  void set_solver(RopeSolver solver);
+  RopeSolver get_solver();
+
+  // update() runs solve_physics, then moves the dragged anchors through
+  // their paths with a solve_constraints at every substep.
+  void solve_physics();
+  void solve_constraints();
+  void update();
+  // Copies every rope's points and colour into out.
+  void capture(RopeDrawList &out);
+  // capture() into a list of its own, then draw it.
+  void draw(SDL_Renderer *renderer, Camera &camera, float alpha);
+
+  // Calls f(name, field) for every piece of simulation state, in a fixed
+  // order. Used for state hashing.
+  template <typename F> void for_each_field(F &&f) {
+    f("rope.count", count);
+    f("rope.stride", stride);
+    f("rope.x_curr", x_curr);
+    f("rope.y_curr", y_curr);
+    f("rope.x_prev", x_prev);
+    f("rope.y_prev", y_prev);
+    f("rope.masses", masses);
+    f("rope.anchored", anchored);
+    f("rope.end_speed", end_speed);
+    f("rope.filtered_speed", filtered_speed);
+  }
+};
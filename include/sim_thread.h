@@ -0,0 +1,90 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "camera.h"
+#include "enemy.h"
+#include "frame_clock.h"
+#include "input.h"
+#include "replay.h"
+#include "rope_system.h"
+#include "simulation.h"
+#include "state_hash.h"
+#include "triple_buffer.h"
+
+using namespace std;
+
+// Everything the renderer needs from one simulation step, copied out of the
+// Simulation so it can be drawn while the next step runs.
+typedef struct {
+  Uint64 step_time;  // SDL_GetTicksNS() the step fell due at
+  Uint64 input_time; // newest mouse input the step has seen
+  Camera camera;
+  RopeDrawList rope;
+  EnemyDrawList enemies; // those in view
+  int altitude;
+  float speed;
+} RenderSnapshot;
+
+// Steps a Simulation at a fixed DT, either on a thread of its own (start())
+// or from the caller's loop (tick()), and publishes a RenderSnapshot after
+// every batch of steps. Input arrives through get_mouse() and
+// set_dragging(); anything else that touches the Simulation or the gGS
+// fields it reads has to hold pause().
+class SimThread {
+  Simulation &sim;
+  InputReplay *replay;     // optional
+  InputRecorder *recorder; // optional
+  StateHashLog *hash_log;  // optional
+  FrameClock clock;
+  int frame;
+
+  MouseSampler mouse;
+  atomic<bool> dragging; // the left button
+  Uint64 input_time;
+
+  mutex lock; // held for every batch of steps
+  thread worker;
+  atomic<bool> quit;
+  atomic<bool> done; // the replay ran out
+
+  TripleBuffer<RenderSnapshot> snapshots;
+  bool have_snapshot; // reader's: something has been acquired
+
+  void publish();
+  void worker_main();
+
+public:
+  SimThread(Simulation &sim, InputReplay *replay, InputRecorder *recorder,
+            StateHashLog *hash_log);
+  ~SimThread();
+
+  // Runs tick() on a new thread until stop() or the end of the replay.
+  void start();
+  void stop();
+
+  // Runs the steps that have fallen due since the last tick and publishes
+  // the result.
+  void tick();
+
+  // While dragging, every step walks the rope's anchor along the mouse
+  // path since the step before, ROPE_ANCHOR_SUBSTEPS points of it.
+  MouseSampler &get_mouse();
+  void set_dragging(bool dragging);
+
+  // Holds off stepping until the lock is released, e.g. to resize the
+  // window or save and load snapshots.
+  unique_lock<mutex> pause();
+
+  // Takes the most recent snapshot; it stays valid until the next call.
+  // Returns nullptr until the first one has been published.
+  RenderSnapshot *latest();
+  // How far real time is past snapshot's step, in steps, clamped to 0..1.
+  float get_alpha(const RenderSnapshot &snapshot);
+
+  // true once a replay has run out of input
+  bool finished();
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include "camera.h"
+#include "enemy.h"
+#include "rope_registry.h"
+
+#include <variant>
+
+// Owns everything that is stepped each frame, independent of any window or
+// renderer, so the same step can be driven by main() or the headless runner.
+class Simulation {
+  AnyRope rope;
+  Camera camera;
+  EnemySystem enemy_system;
+  Uint64 rng_state;
+
+public:
+  Simulation(Uint64 seed);
+  ~Simulation();
+
+  // The player's rope is one of the registered rope types. Changing the type
+  // replaces it with a fresh rope.
+  void set_rope_type(int type);
+  int get_rope_type();
+  template <typename F> decltype(auto) visit_rope(F &&f) {
+    return std::visit(f, rope);
+  }
+
+  Camera &get_camera();
+  EnemySystem &get_enemy_system();
+
+  // mouse is the drag input through the step, in world space.
+  void step(const AnchorPath &mouse);
+  void step(SDL_FPoint mouseWorld);
+
+  template <typename F> void for_each_field(F &&f) {
+    std::visit([&](auto &r) { r.for_each_field(f); }, rope);
+    camera.for_each_field(f);
+    enemy_system.for_each_field(f);
+    f("sim.rng_state", rng_state);
+  }
+};
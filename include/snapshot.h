@@ -0,0 +1,39 @@
+#pragma once
+
+#include "simulation.h"
+
+#define SNAPSHOT_MAGIC 0x4e534c53u // "SLSN"
+#define SNAPSHOT_VERSION 2u
+#define SNAPSHOT_ALIGN 64
+#define SNAPSHOT_NAME_LEN 32
+
+// File layout, native byte order (the header records it):
+//   SnapshotHeader
+//   field_count x SnapshotField
+//   field data, each field starting on a SNAPSHOT_ALIGN boundary
+// Loading maps the file and copies each field with one memcpy, so load time
+// is independent of how many entities the snapshot holds.
+typedef struct {
+  Uint32 magic;
+  Uint32 version;
+  Uint32 byte_order; // 0x01020304 as written by the saving machine
+  Uint32 field_count;
+  Uint32 rope_type; // Simulation::get_rope_type() of the saved world
+  Uint32 reserved;
+  Uint64 file_size;
+} SnapshotHeader;
+
+typedef struct {
+  char name[SNAPSHOT_NAME_LEN];
+  Uint64 offset;
+  Uint64 bytes;
+  Uint32 elem_size;
+  Uint32 reserved;
+} SnapshotField;
+
+// Saves every Simulation field plus the window size the floor depends on.
+bool save_snapshot(const char *path, Simulation &sim);
+
+// Restores a snapshot written by save_snapshot into sim and gGS. Fails
+// without touching sim if the file's field table doesn't match this build.
+bool load_snapshot(const char *path, Simulation &sim);
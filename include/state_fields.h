@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Raw byte view of one piece of simulation state, as handed out by the
+// for_each_field visitors on Rope, Camera, EnemySystem and Simulation. State
+// is either a trivially copyable scalar or a vector of them.
+template <typename T> struct FieldView {
+  static constexpr bool resizable = false;
+  static void *data(T &field) { return &field; }
+  static size_t bytes(T &) { return sizeof(T); }
+  static void resize(T &, size_t) {}
+  static size_t elem_size() { return sizeof(T); }
+};
+
+template <typename T, typename A> struct FieldView<vector<T, A>> {
+  static constexpr bool resizable = true;
+  static void *data(vector<T, A> &field) { return field.data(); }
+  static size_t bytes(vector<T, A> &field) { return field.size() * sizeof(T); }
+  static void resize(vector<T, A> &field, size_t n) { field.resize(n); }
+  static size_t elem_size() { return sizeof(T); }
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <string>
+#include <vector>
+
+#include "simulation.h"
+
+using namespace std;
+
+#define HASH_LOG_MAGIC 0x53484c53u // "SLHS"
+#define HASH_LOG_VERSION 1u
+
+// 64-bit hash of a byte range, 8 bytes per step. Not cryptographic; only
+// meant to tell bit-identical state apart from anything else.
+Uint64 hash_bytes(const void *data, size_t bytes);
+
+// Hashes every field of sim, in for_each_field order.
+void hash_state(Simulation &sim, vector<Uint64> &out);
+
+// File layout, all little endian:
+//   u32 magic, u32 version, u32 field_count,
+//   field_count x { u8 name_len, name bytes }
+//   per frame: u32 frame, field_count x u64 hash
+class StateHashLog {
+  SDL_IOStream *io;
+  vector<Uint64> hashes;
+
+public:
+  StateHashLog();
+  ~StateHashLog();
+
+  bool open(const char *path, Simulation &sim);
+  void write(int frame, Simulation &sim);
+  void close();
+};
+
+// Compares two hash logs and reports the first frame and field that differ.
+// Returns 0 if they match frame for frame, 1 on divergence (a log ending
+// before the other included) and 2 if either file can't be read or they
+// record different fields.
+int compare_hash_logs(const char *path_a, const char *path_b);
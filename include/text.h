@@ -0,0 +1,61 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3_ttf/SDL_ttf.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define GLYPH_FIRST 32
+#define GLYPH_LAST 126
+#define GLYPH_ATLAS_WIDTH 512
+
+typedef struct {
+  SDL_FRect src; // pixels in the atlas texture
+  float advance;
+} Glyph;
+
+// Printable ASCII rendered once into a single texture at startup.
+class GlyphAtlas {
+  SDL_Texture *texture;
+  Glyph glyphs[GLYPH_LAST - GLYPH_FIRST + 1];
+  float line_height;
+
+public:
+  GlyphAtlas();
+  ~GlyphAtlas();
+
+  bool build(SDL_Renderer *renderer, TTF_Font *font);
+  bool ready();
+  const Glyph &get(char c);
+  SDL_Texture *get_texture();
+  float get_line_height();
+};
+
+// A string laid out as atlas quads relative to its top-left corner. Layout
+// is redone only when the text actually changes.
+class TextLabel {
+  string text;
+  vector<SDL_Vertex> vertices; // 4 per glyph
+  float width;
+
+public:
+  TextLabel();
+  ~TextLabel();
+
+  void set_text(GlyphAtlas &atlas, const string &new_text);
+  const string &get_text();
+  float get_width();
+  const vector<SDL_Vertex> &get_vertices() const;
+};
+
+// Gathers any number of labels into one SDL_RenderGeometry call.
+class TextBatch {
+  vector<SDL_Vertex> vertices;
+  vector<int> indices;
+
+public:
+  void add(const TextLabel &label, float x, float y, SDL_FColor color);
+  void draw(SDL_Renderer *renderer, GlyphAtlas &atlas);
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <vector>
+
+using namespace std;
+
+typedef struct {
+  SDL_FRect src; // in its atlas
+  float x, y;    // top-left in the original image
+} ImageTile;
+
+// An image cut into tile x tile squares with the fully transparent ones
+// dropped. The rest are packed into two atlases: tiles that are opaque all
+// the way to their edges, drawn without blending, and everything else.
+// Every atlas cell carries a one pixel gutter copied from the neighbouring
+// image pixels so filtering at a tile's edge samples what the whole image
+// would have had there.
+typedef struct {
+  int w, h; // of the original image
+  int tile;
+  int total_tiles; // before dropping, for the log
+  vector<ImageTile> opaque_tiles;
+  vector<ImageTile> blend_tiles;
+  // atlases: surfaces until AssetLoader::upload(), textures after
+  SDL_Surface *opaque_atlas;
+  SDL_Surface *blend_atlas;
+  SDL_Texture *opaque_texture; // SDL_BLENDMODE_NONE
+  SDL_Texture *blend_texture;
+} TiledImage;
+
+// Splits image (any pixel format) into out's tiles and atlas surfaces.
+bool tile_image(SDL_Surface *image, int tile, TiledImage &out);
+
+// Turns the atlas surfaces into textures and frees them.
+bool upload_tiled_image(SDL_Renderer *renderer, TiledImage &image);
+
+void free_tiled_image(TiledImage &image);
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "assets.h"
+#include "camera.h"
+
+using namespace std;
+
+#define TILEMAP_MAGIC 0x4d544c53u // "SLTM"
+#define TILEMAP_VERSION 1u
+#define TILEMAP_BYTE_ORDER 0x01020304u
+#define TILEMAP_PATH_LEN 128
+#define TILEMAP_NAME_LEN 32
+#define TILEMAP_DEFAULT_CHUNK 32                  // tiles per chunk side
+#define TILEMAP_DEFAULT_BUDGET (4u * 1024u * 1024u) // bytes of resident tiles
+#define TILEMAP_PREFETCH_CHUNKS 1 // ring of chunks loaded around the view
+
+// Tiled stores flips in the top bits of every gid
+#define TILEMAP_FLIP_H 0x80000000u
+#define TILEMAP_FLIP_V 0x40000000u
+#define TILEMAP_FLIP_D 0x20000000u
+#define TILEMAP_GID_MASK 0x0fffffffu
+
+// Cooked map layout, native byte order (the header records it):
+//   TileMapHeader
+//   tileset_count x TileMapTileset
+//   layer_count x TileMapLayer
+//   layer_count * chunks_y * chunks_x x TileMapChunk, layer-major then row
+//   chunk payloads
+// A chunk covers chunk_tiles x chunk_tiles tiles of one layer. Its payload
+// is `runs` run-length pairs {Uint32 count, Uint32 gid} covering the chunk
+// row by row; chunks with no tiles at all have runs == 0 and no payload.
+typedef struct {
+  Uint32 magic;
+  Uint32 version;
+  Uint32 byte_order; // 0x01020304 as written by the cooking machine
+  Uint32 tile_w, tile_h;
+  Uint32 width, height; // in tiles
+  Uint32 chunk_tiles;
+  Uint32 chunks_x, chunks_y;
+  Uint32 tileset_count;
+  Uint32 layer_count;
+  Uint64 file_size;
+} TileMapHeader;
+
+typedef struct {
+  char image[TILEMAP_PATH_LEN]; // relative to the working directory
+  Uint32 first_gid;
+  Uint32 tile_count;
+  Uint32 columns;
+  Uint32 tile_w, tile_h;
+  Uint32 margin, spacing;
+  Uint32 image_w, image_h;
+  Uint32 reserved;
+} TileMapTileset;
+
+typedef struct {
+  char name[TILEMAP_NAME_LEN];
+  float opacity;
+  float offset_x, offset_y; // pixels
+  Uint32 visible;
+} TileMapLayer;
+
+typedef struct {
+  Uint64 offset;
+  Uint32 runs;
+  Uint32 tiles; // non-empty tiles
+} TileMapChunk;
+
+// Offline step behind `slinger_cook map`: reads a Tiled JSON map (.tmj)
+// with embedded or JSON (.tsj) tilesets and writes the cooked format above.
+bool cook_tiled_map(const char *json_path, const char *out_path,
+                    int chunk_tiles);
+
+// A cooked map, streamed from disk. Only the chunk table is read up front;
+// stream() keeps the chunks around the view resident and evicts the least
+// recently used ones beyond the memory budget, and draw() submits the
+// visible tiles with one SDL_RenderGeometry per run of tiles sharing a
+// tileset texture. With a loader set, chunks are read and decoded on its
+// workers and a chunk still on its way is drawn empty, so crossing into new
+// chunks never waits on the disk.
+class TileMap {
+  typedef struct {
+    int chunk;
+    Uint64 last_used;
+    vector<Uint32> tiles; // chunk_tiles^2 gids, row by row
+  } Slot;
+
+  // One chunk on its way in. The job owns everything but done until it
+  // sets done; stream() then moves the tiles into a slot.
+  typedef struct {
+    int chunk;
+    TileMapChunk table; // its entry, copied so the job needs nothing else
+    vector<Uint32> tiles;
+    bool ok;
+    atomic<bool> done;
+  } ChunkLoad;
+
+  SDL_IOStream *io;
+  mutex io_lock; // chunk jobs share io
+  AssetLoader *loader; // optional, see set_loader()
+  TileMapHeader header;
+  vector<TileMapTileset> tilesets;
+  vector<SDL_Texture *> textures;
+  vector<TileMapLayer> layers;
+  vector<TileMapChunk> chunks;
+  vector<int> slot_of; // per chunk; -1 when not resident
+  vector<Slot> slots;
+  vector<unique_ptr<ChunkLoad>> pending;
+  vector<Uint8> requested; // per chunk: a ChunkLoad is pending for it
+  size_t budget;
+  Uint64 frame;
+  int loads;
+  SDL_FPoint origin; // world position of the map's top-left corner
+
+  vector<SDL_Vertex> vertices;
+  vector<int> indices;
+
+  // Reads and decodes load.table; runs on a loader worker or inline.
+  void read_chunk(ChunkLoad &load);
+  void request_chunk(int chunk);
+  // Moves finished loads into slots, evicting as stream() would.
+  void install_loads(size_t max_slots);
+  int take_slot(size_t max_slots);
+  int tileset_for(Uint32 gid);
+  // true if any tile of a layer can overlap the view; fills the tile range
+  bool tile_range(const TileMapLayer &layer, const SDL_FRect &view, int &tx0,
+                  int &ty0, int &tx1, int &ty1);
+  void flush(SDL_Renderer *renderer, SDL_Texture *texture);
+
+public:
+  TileMap();
+  ~TileMap();
+
+  // Reads the header and tables and loads the tileset textures. The map's
+  // bottom edge starts out resting on the floor.
+  bool open(const char *path, SDL_Renderer *renderer);
+  void close();
+  bool is_open();
+
+  void set_budget(size_t bytes);
+  void set_origin(SDL_FPoint origin);
+  // Reads chunks on loader's workers from now on rather than inside
+  // stream(). The loader must outlive the map, or at least its close().
+  void set_loader(AssetLoader *loader);
+
+  // Requests the chunks around the camera's view that aren't resident yet
+  // and takes in the ones that have arrived since the last call.
+  void stream(Camera &camera);
+  void draw(SDL_Renderer *renderer, Camera &camera);
+
+  int get_resident_chunks();
+  size_t get_resident_bytes();
+  // chunks the last stream() took in
+  int get_loads();
+};
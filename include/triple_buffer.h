@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+
+using namespace std;
+
+// Hands the latest value of T from one writer thread to one reader thread
+// without locking or waiting. There are three slots: the writer fills its
+// back slot and publishes it by swapping it with the middle one, and the
+// reader picks up a freshly published middle slot by swapping it with its
+// front slot. Neither side ever touches the slot the other holds, so both
+// can keep scratch in their slots and reuse it, and the reader always sees
+// a whole value, however far the writer gets ahead.
+template <typename T> class TripleBuffer {
+  // set on middle when it holds a value the reader hasn't taken yet
+  static constexpr int FRESH = 4;
+
+  T slots[3];
+  atomic<int> middle; // slot index | FRESH
+  int back;           // writer's
+  int front;          // reader's
+
+public:
+  TripleBuffer() : middle(1), back(0), front(2) {}
+
+  // Writer: the slot to fill before publish(). It holds whatever was in it
+  // last time round, not the latest value.
+  T &write_slot() { return slots[back]; }
+
+  // Writer: makes the back slot the latest value.
+  void publish() {
+    back = middle.exchange(back | FRESH, memory_order_acq_rel) & ~FRESH;
+  }
+
+  // Reader: moves the latest published value, if there is a newer one, into
+  // the front slot. Returns whether the front slot changed.
+  bool acquire() {
+    if (!(middle.load(memory_order_relaxed) & FRESH))
+      return false;
+    front = middle.exchange(front, memory_order_acq_rel) & ~FRESH;
+    return true;
+  }
+
+  // Reader: the value picked up by the last acquire().
+  T &read() { return slots[front]; }
+};
@@ -3,11 +3,34 @@
 #include "SDL3/SDL_render.h"
 #include <SDL3_ttf/SDL_ttf.h>
 
+#include "assets.h"
+#include "text.h"
+
 class UI {
-  TTF_Font *font;
+  AssetLoader &assets;
+  AssetHandle font; // the HUD draws nothing until it has loaded
+  bool show_profiler = false;
+
+  // HUD text is laid out from a glyph atlas built on the first draw and is
+  // only re-laid out when the displayed value changes.
+  GlyphAtlas atlas;
+  TextBatch text_batch;
+  TextLabel altitude_label;
+  TextLabel speed_label;
+  TextLabel latency_label;
+  TextLabel profiler_label;
+  int shown_altitude = 0;
+  int shown_speed_centi = 0;
+  int shown_latency_deci = -1;
+
+  void draw_profiler(SDL_Renderer *renderer);
 
 public:
-  UI();
+  UI(AssetLoader &assets);
   ~UI();
-  void draw(SDL_Renderer *renderer);
+  void toggle_profiler();
+  // The HUD values come from the caller rather than gGS, so they can be
+  // read from a render snapshot. latency_ms < 0 hides the latency line.
+  void draw(SDL_Renderer *renderer, int altitude, float speed,
+            float latency_ms);
 };
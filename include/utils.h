@@ -3,12 +3,10 @@
 #include <SDL3/SDL.h>
 #include <cmath>
 
-#define NUM_POINTS 20
 #define BALL_RADIUS 10.0f
-#define POINT_SPACING 10.0f
 #define GRAVITY 1000.0f
 #define DT 0.016f
-#define CONSTRAINT_ITERATIONS 40
+// enemy integration; rope tuning lives in RopeConfig (rope_registry.h)
 #define DAMPING 0.999f
 #define AIR_RESISTANCE 0.03f
 #define CAMERA_LERP 0.2f
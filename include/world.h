@@ -2,14 +2,22 @@
 
 #include <SDL3/SDL.h>
 #include <cmath>
+#include <vector>
 
+#include "assets.h"
 #include "camera.h"
 
+// Layer art is cut into tiles of this many source pixels at load time
+#define BG_TILE_SIZE 32
+
 struct BGLayer {
-  SDL_Texture *texture;
+  AssetHandle image;
+  const TiledImage *tiles; // nullptr until the loader has uploaded it
   float scrollSpeed;
   float offsetX; // scroll offset
   float offsetY; // scroll offset
+  float drawW;   // image size times the layer scale, set on arrival
+  float drawH;
 };
 
 class Background {
@@ -20,14 +28,44 @@ class Background {
   };
 
   const float scrollSpeeds[6] = {0.06f, 0.2f, 0.4f, 0.65f, 1.0f, 1.33f};
+  // Flat stand-ins drawn until a layer's art arrives, far to near
+  const SDL_Color placeholderColors[6] = {
+      {38, 44, 72, 255},  {44, 52, 84, 255},  {36, 46, 70, 255},
+      {30, 40, 58, 255},  {24, 32, 46, 255},  {18, 24, 34, 255},
+  };
+  const float layerScale = 1.5f; // static_cast<float>(gGS.winW) / texW;
   BGLayer layers[6];
+  AssetLoader &assets;
+
+  // quads of the layer being drawn, reused across layers and frames
+  std::vector<SDL_Vertex> opaqueVertices;
+  std::vector<SDL_Vertex> blendVertices;
+  std::vector<int> indices;
+
+  // Picks up the layer's tiles once the loader has them and caches its
+  // scaled size; false while it's still loading.
+  bool resolve(BGLayer &layer);
+  // Appends a quad per tile that lands on screen when the layer's top-left
+  // is at (left, top), wrapping horizontally every drawW pixels.
+  void add_tiles(const BGLayer &layer, const std::vector<ImageTile> &tiles,
+                 SDL_Texture *texture, float left, float top,
+                 std::vector<SDL_Vertex> &out);
+  void submit(SDL_Renderer *renderer, SDL_Texture *texture,
+              const std::vector<SDL_Vertex> &vertices);
 
 public:
-  bool load(SDL_Renderer *renderer);
+  // Queues the layer images on the loader; the background starts drawing
+  // placeholders straight away and swaps each layer in once it's uploaded.
+  void load();
 
-  Background(SDL_Renderer *renderer);
+  Background(AssetLoader &assets);
 
   ~Background();
 
+  // Layers are stored as tiles with the empty ones dropped (see
+  // tiled_image.h). Each layer submits the on-screen copies of its opaque
+  // tiles in one unblended SDL_RenderGeometry call and the rest in one
+  // blended call. Layers scrolled fully above or below the window are
+  // skipped.
   void draw(SDL_Renderer *renderer, Camera &camera);
 };
@@ -0,0 +1,221 @@
+#include "assets.h"
+#include "profiler.h"
+
+#include <algorithm>
+
+AssetLoader::AssetLoader(int threads)
+    : first_unready(0), pack(nullptr), quit(false) {
+  threads = std::max(threads, 1);
+  for (int i = 0; i < threads; i++)
+    workers.emplace_back(&AssetLoader::worker_main, this);
+}
+
+AssetLoader::~AssetLoader() {
+  {
+    lock_guard<mutex> lk(queue_lock);
+    quit = true;
+  }
+  wake.notify_all();
+  for (thread &t : workers)
+    t.join();
+
+  for (auto &asset : assets) {
+    if (asset->surface)
+      SDL_DestroySurface(asset->surface);
+    if (asset->texture)
+      SDL_DestroyTexture(asset->texture);
+    free_tiled_image(asset->tiled);
+    if (asset->font)
+      TTF_CloseFont(asset->font);
+  }
+}
+
+AssetHandle AssetLoader::add(AssetKind kind, const char *path, float size,
+                             int tile) {
+  auto asset = make_unique<Asset>();
+  asset->kind = kind;
+  asset->path = path;
+  asset->size = size;
+  asset->tile = tile;
+  asset->state = ASSET_PENDING;
+  asset->entry = pack ? pack->find(path) : nullptr;
+  asset->surface = nullptr;
+  asset->texture = nullptr;
+  asset->tiled = {};
+  asset->font = nullptr;
+  PackEntryKind wanted =
+      kind == ASSET_FONT ? PACK_ENTRY_BYTES : PACK_ENTRY_PIXELS;
+  if (asset->entry && asset->entry->kind != (Uint32)wanted)
+    asset->entry = nullptr;
+  if (kind == ASSET_IMAGE && asset->entry) {
+    // already decoded; only the upload is left
+    asset->state = ASSET_DECODED;
+    assets.push_back(std::move(asset));
+    return (AssetHandle)assets.size() - 1;
+  }
+  run([this, queued = asset.get()] { decode(*queued); });
+  assets.push_back(std::move(asset));
+  return (AssetHandle)assets.size() - 1;
+}
+
+void AssetLoader::mount(AssetPack *pack) { this->pack = pack; }
+
+void AssetLoader::run(function<void()> job) {
+  {
+    lock_guard<mutex> lk(queue_lock);
+    queue.push_back(std::move(job));
+  }
+  wake.notify_one();
+}
+
+AssetHandle AssetLoader::load_image(const char *path) {
+  return add(ASSET_IMAGE, path, 0.0f, 0);
+}
+
+AssetHandle AssetLoader::load_tiled_image(const char *path, int tile) {
+  return add(ASSET_TILED_IMAGE, path, 0.0f, tile);
+}
+
+AssetHandle AssetLoader::load_font(const char *path, float size) {
+  return add(ASSET_FONT, path, size, 0);
+}
+
+void AssetLoader::decode(Asset &asset) {
+  PROFILE_ZONE("asset.decode");
+  if (asset.kind == ASSET_IMAGE) {
+    asset.surface = SDL_LoadPNG(asset.path.c_str());
+    if (!asset.surface) {
+      SDL_Log("Failed to load %s: %s", asset.path.c_str(), SDL_GetError());
+      asset.state.store(ASSET_FAILED, memory_order_release);
+      return;
+    }
+    asset.state.store(ASSET_DECODED, memory_order_release);
+    return;
+  }
+
+  if (asset.kind == ASSET_TILED_IMAGE) {
+    // packed pixels are wrapped where they're mapped, not copied
+    const PackEntry *e = asset.entry;
+    SDL_Surface *image =
+        e ? SDL_CreateSurfaceFrom(e->w, e->h, (SDL_PixelFormat)e->format,
+                                  (void *)pack->data(*e), e->pitch)
+          : SDL_LoadPNG(asset.path.c_str());
+    bool ok = image && tile_image(image, asset.tile, asset.tiled);
+    if (image)
+      SDL_DestroySurface(image);
+    if (!ok) {
+      SDL_Log("Failed to load %s: %s", asset.path.c_str(), SDL_GetError());
+      asset.state.store(ASSET_FAILED, memory_order_release);
+      return;
+    }
+    asset.state.store(ASSET_DECODED, memory_order_release);
+    return;
+  }
+
+  {
+    lock_guard<mutex> lk(font_lock);
+    if (asset.entry)
+      asset.font =
+          TTF_OpenFontIO(pack->open_io(*asset.entry), true, asset.size);
+    else
+      asset.font = TTF_OpenFont(asset.path.c_str(), asset.size);
+  }
+  if (!asset.font) {
+    SDL_Log("Failed to load font %s: %s", asset.path.c_str(), SDL_GetError());
+    asset.state.store(ASSET_FAILED, memory_order_release);
+    return;
+  }
+  asset.state.store(ASSET_READY, memory_order_release);
+}
+
+void AssetLoader::worker_main() {
+  for (;;) {
+    function<void()> job;
+    {
+      unique_lock<mutex> lk(queue_lock);
+      wake.wait(lk, [&] { return quit || !queue.empty(); });
+      if (quit)
+        return;
+      job = std::move(queue.front());
+      queue.pop_front();
+    }
+    job();
+  }
+}
+
+void AssetLoader::upload(SDL_Renderer *renderer, size_t budget) {
+  size_t spent = 0;
+  for (size_t i = first_unready; i < assets.size() && spent < budget; i++) {
+    Asset &asset = *assets[i];
+    if (asset.state.load(memory_order_acquire) != ASSET_DECODED)
+      continue;
+
+    PROFILE_ZONE("asset.upload");
+    if (asset.kind == ASSET_TILED_IMAGE) {
+      TiledImage &t = asset.tiled;
+      for (SDL_Surface *atlas : {t.opaque_atlas, t.blend_atlas})
+        if (atlas)
+          spent += (size_t)atlas->pitch * atlas->h;
+      if (!upload_tiled_image(renderer, t)) {
+        SDL_Log("Failed to create textures for %s: %s", asset.path.c_str(),
+                SDL_GetError());
+        asset.state.store(ASSET_FAILED, memory_order_release);
+        continue;
+      }
+      asset.state.store(ASSET_READY, memory_order_release);
+      SDL_Log("Loaded %s: (%d x %d), %zu opaque and %zu blended of %d "
+              "%d px tiles",
+              asset.path.c_str(), t.w, t.h, t.opaque_tiles.size(),
+              t.blend_tiles.size(), t.total_tiles, t.tile);
+      continue;
+    }
+    if (asset.entry) {
+      asset.texture = pack->create_texture(renderer, *asset.entry);
+      spent += (size_t)asset.entry->pitch * asset.entry->h;
+    } else {
+      SDL_Surface *surface = asset.surface;
+      asset.texture = SDL_CreateTextureFromSurface(renderer, surface);
+      spent += (size_t)surface->pitch * surface->h;
+      asset.surface = nullptr;
+      SDL_DestroySurface(surface);
+    }
+    if (!asset.texture) {
+      SDL_Log("Failed to create texture for %s: %s", asset.path.c_str(),
+              SDL_GetError());
+      asset.state.store(ASSET_FAILED, memory_order_release);
+      continue;
+    }
+    asset.state.store(ASSET_READY, memory_order_release);
+
+    float w, h;
+    SDL_GetTextureSize(asset.texture, &w, &h);
+    SDL_Log("Loaded %s: (%f x %f)", asset.path.c_str(), w, h);
+  }
+
+  while (first_unready < assets.size()) {
+    int state = assets[first_unready]->state.load(memory_order_acquire);
+    if (state != ASSET_READY && state != ASSET_FAILED)
+      break;
+    first_unready++;
+  }
+}
+
+AssetState AssetLoader::get_state(AssetHandle handle) {
+  if (handle < 0 || handle >= (int)assets.size())
+    return ASSET_FAILED;
+  return (AssetState)assets[handle]->state.load(memory_order_acquire);
+}
+
+SDL_Texture *AssetLoader::get_texture(AssetHandle handle) {
+  return get_state(handle) == ASSET_READY ? assets[handle]->texture : nullptr;
+}
+
+const TiledImage *AssetLoader::get_tiled_image(AssetHandle handle) {
+  return get_state(handle) == ASSET_READY ? &assets[handle]->tiled : nullptr;
+}
+
+TTF_Font *AssetLoader::get_font(AssetHandle handle) {
+  return get_state(handle) == ASSET_READY ? assets[handle]->font : nullptr;
+}
+
+bool AssetLoader::busy() { return first_unready < assets.size(); }
@@ -7,6 +7,7 @@
 Camera::Camera() {
   pos = {0.0f, 0.0f};
   speed = 0.0f;
+  prev_pos = pos;
 }
 Camera::~Camera() {}
 
@@ -19,11 +20,43 @@ SDL_FPoint Camera::screenToWorld(const SDL_FPoint &screen) const {
           screen.y + pos.y - gGS.winH / 2.0f};
 }
 
+void Camera::world_to_screen(const float *x, const float *y, SDL_FPoint *out,
+                             int n) const {
+  float off_x = gGS.winW / 2.0f - pos.x;
+  float off_y = gGS.winH / 2.0f - pos.y;
+  for (int i = 0; i < n; i++) {
+    out[i].x = x[i] + off_x;
+    out[i].y = y[i] + off_y;
+  }
+}
+
+void Camera::world_to_screen(const float *x, const float *y, const int *index,
+                             SDL_FPoint *out, int n) const {
+  float off_x = gGS.winW / 2.0f - pos.x;
+  float off_y = gGS.winH / 2.0f - pos.y;
+  for (int k = 0; k < n; k++) {
+    out[k].x = x[index[k]] + off_x;
+    out[k].y = y[index[k]] + off_y;
+  }
+}
+
+SDL_FRect Camera::get_view() const {
+  return {pos.x - gGS.winW / 2.0f, pos.y - gGS.winH / 2.0f, (float)gGS.winW,
+          (float)gGS.winH};
+}
+
+SDL_FRect Camera::get_swept_view() const {
+  SDL_FRect view = get_view();
+  float dx = prev_pos.x - pos.x, dy = prev_pos.y - pos.y;
+  return {view.x + std::min(dx, 0.0f), view.y + std::min(dy, 0.0f),
+          view.w + SDL_fabsf(dx), view.h + SDL_fabsf(dy)};
+}
+
 SDL_FPoint Camera::get_pos() { return pos; }
 
-SDL_FPoint Camera::rand_point_in_view() {
-  float randX = SDL_randf();
-  float randY = SDL_randf();
+SDL_FPoint Camera::rand_point_in_view(Uint64 &rng_state) {
+  float randX = SDL_randf_r(&rng_state);
+  float randY = SDL_randf_r(&rng_state);
 
   float screenX = randX * gGS.winW;
   float screenY = randY * gGS.winH;
@@ -35,6 +68,7 @@ SDL_FPoint Camera::rand_point_in_view() {
 }
 
 void Camera::update(SDL_FPoint anchor, SDL_FPoint end) {
+  prev_pos = pos;
   if (!gGS.isDragging)
     speed = lerp1D(speed, 0.3f, 0.3f);
   else
@@ -45,3 +79,11 @@ void Camera::update(SDL_FPoint anchor, SDL_FPoint end) {
   pos = lerp2D(pos, target, speed);
   pos.y = std::min(pos.y, (float)gGS.winH / 2.0f);
 }
+
+Camera Camera::interpolated(float alpha) const {
+  Camera view = *this;
+  view.pos = lerp2D(prev_pos, pos, alpha);
+  return view;
+}
+
+void Camera::settle() { prev_pos = pos; }
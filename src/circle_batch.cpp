@@ -0,0 +1,78 @@
+#include "circle_batch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define CIRCLE_MIN_SEGMENTS 8
+#define CIRCLE_MAX_SEGMENTS 64
+
+static int segments_for(int32_t radius) {
+  return std::clamp((int)(radius * 2.5f), CIRCLE_MIN_SEGMENTS,
+                    CIRCLE_MAX_SEGMENTS);
+}
+
+CircleBatch::CircleBatch() {
+  count = 0;
+  unit_segments = 0;
+}
+
+CircleBatch::~CircleBatch() {}
+
+void CircleBatch::build_unit(int segments) {
+  unit.resize(segments);
+  for (int i = 0; i < segments; ++i) {
+    float angle = 2.0f * SDL_PI_F * i / segments;
+    unit[i] = {cosf(angle), sinf(angle)};
+  }
+  unit_segments = segments;
+}
+
+void CircleBatch::add(int32_t centerX, int32_t centerY, int32_t radius,
+                      SDL_FColor color) {
+  int segments = segments_for(radius);
+  if (segments != unit_segments)
+    build_unit(segments);
+
+  // draw_circle fills every pixel whose offset from the centre pixel is within
+  // radius, i.e. every pixel centre within radius of the centre pixel's
+  // centre. Circumscribe the polygon so its flat edges don't shave those off.
+  float cx = centerX + 0.5f;
+  float cy = centerY + 0.5f;
+  float r = radius / cosf(SDL_PI_F / segments);
+
+  int base = (int)vertices.size();
+  vertices.push_back({{cx, cy}, color, {0.0f, 0.0f}});
+  for (int i = 0; i < segments; ++i) {
+    vertices.push_back(
+        {{cx + r * unit[i].x, cy + r * unit[i].y}, color, {0.0f, 0.0f}});
+  }
+
+  for (int i = 0; i < segments; ++i) {
+    indices.push_back(base);
+    indices.push_back(base + 1 + i);
+    indices.push_back(base + 1 + (i + 1) % segments);
+  }
+  count++;
+}
+
+void CircleBatch::draw(SDL_Renderer *renderer) {
+  if (!indices.empty())
+    SDL_RenderGeometry(renderer, nullptr, vertices.data(),
+                       (int)vertices.size(), indices.data(),
+                       (int)indices.size());
+  clear();
+}
+
+void CircleBatch::clear() {
+  vertices.clear();
+  indices.clear();
+  count = 0;
+}
+
+int CircleBatch::get_count() { return count; }
+
+SDL_FColor get_draw_color(SDL_Renderer *renderer) {
+  Uint8 r, g, b, a;
+  SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+  return {r / 255.0f, g / 255.0f, b / 255.0f, a / 255.0f};
+}
@@ -1,156 +1,346 @@
 #include "enemy.h"
 
+#include "enemy_simd.h"
 #include "globals.h"
+#include "job_pool.h"
 #include "utils.h"
+#include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <sys/types.h>
 
-EnemyGrid::EnemyGrid(float enemy_radius) { cell_size = enemy_radius * 4.0f; }
+EnemyGrid::EnemyGrid(float enemy_radius) {
+  base_cell_size = enemy_radius * 4.0f;
+  cell_size = base_cell_size;
+  origin_cx = 0;
+  origin_cy = 0;
+  cols = 0;
+  rows = 0;
+}
 
-EnemyGrid::~EnemyGrid() { clear(); }
+EnemyGrid::~EnemyGrid() {}
 
-void EnemyGrid::clear() { grid.clear(); }
+void EnemyGrid::rebuild(const float *x, const float *y, int count) {
+  float min_x = 0.0f, min_y = 0.0f, max_x = 0.0f, max_y = 0.0f;
+  if (count > 0) {
+    min_x = max_x = grid_coord(x[0]);
+    min_y = max_y = grid_coord(y[0]);
+  }
+  for (int i = 1; i < count; i++) {
+    min_x = std::min(min_x, grid_coord(x[i]));
+    max_x = std::max(max_x, grid_coord(x[i]));
+    min_y = std::min(min_y, grid_coord(y[i]));
+    max_y = std::max(max_y, grid_coord(y[i]));
+  }
+
+  // Grow cells when enemies are spread so thin that the box would need far
+  // more cells than enemies. Anything at least base_cell_size wide still
+  // contains every neighbour in the surrounding 3x3 block.
+  int max_cells = std::max(count * GRID_MAX_CELLS_PER_ENEMY, GRID_MIN_CELLS);
+  cell_size = base_cell_size;
+  for (;;) {
+    origin_cx = (int)SDL_floorf(min_x / cell_size);
+    origin_cy = (int)SDL_floorf(min_y / cell_size);
+    cols = (int)SDL_floorf(max_x / cell_size) - origin_cx + 1;
+    rows = (int)SDL_floorf(max_y / cell_size) - origin_cy + 1;
+    if ((int64_t)cols * rows <= max_cells)
+      break;
+    cell_size *= 2.0f;
+  }
+
+  int cells = cols * rows;
+  cell_start.assign(cells + 1, 0);
+  enemy_cell.resize(count);
+  cell_index.resize(count);
+
+  // pass 1: count enemies per cell
+  for (int i = 0; i < count; i++) {
+    int c = cell_y(y[i]) * cols + cell_x(x[i]);
+    enemy_cell[i] = c;
+    cell_start[c + 1]++;
+  }
+  for (int c = 0; c < cells; c++)
+    cell_start[c + 1] += cell_start[c];
 
-void EnemyGrid::add(float x, float y, int index) {
-  int cell_x = floorf(x / cell_size);
-  int cell_y = floorf(y / cell_size);
-  uint64_t cell_key = (uint64_t)(uint32_t)cell_x << 32 | (uint32_t)cell_y;
+  // pass 2: scatter indices, in increasing order within each cell
+  cell_cursor.assign(cell_start.begin(), cell_start.end() - 1);
+  for (int i = 0; i < count; i++)
+    cell_index[cell_cursor[enemy_cell[i]]++] = i;
+}
 
-  grid[cell_key].push_back(index);
+bool EnemyGrid::cell_range(float min_x, float min_y, float max_x, float max_y,
+                           int &cx0, int &cy0, int &cx1, int &cy1) const {
+  cx0 = std::max(cell_x(min_x), 0);
+  cy0 = std::max(cell_y(min_y), 0);
+  cx1 = std::min(cell_x(max_x), cols - 1);
+  cy1 = std::min(cell_y(max_y), rows - 1);
+  return cx0 <= cx1 && cy0 <= cy1;
 }
 
-unordered_map<uint64_t, vector<int>> &EnemyGrid::get_grid() { return grid; }
+float EnemyGrid::get_cell_size() const { return cell_size; }
+
+int EnemyGrid::get_cols() const { return cols; }
 
-float EnemyGrid::get_cell_size() { return cell_size; }
+int EnemyGrid::get_rows() const { return rows; }
 
 EnemySystem::EnemySystem() : enemy_grid(gGS.enemy_radius) {
   count = 0;
   timer = 0.0f;
   spawn_time = 2.0f;
+  grid_dirty = true;
+  max_radius = 0.0f;
+  max_speed = 0.0f;
+  rope_frame = 0;
+  lifetime = ENEMY_DEFAULT_LIFETIME;
+  despawn_distance = ENEMY_DEFAULT_DESPAWN_DISTANCE;
+  set_capacity(ENEMY_DEFAULT_CAPACITY);
 }
 
 EnemySystem::~EnemySystem() {}
 
-void EnemySystem::add(EnemyType type, float x, float y) {
-  if (type == EnemyType::Base) {
-    enemy_type.push_back(EnemyType::Base);
+int EnemySystem::get_count() { return count; }
 
-    x_curr.push_back(x);
-    y_curr.push_back(y);
-    x_prev.push_back(x);
-    y_prev.push_back(y);
+int EnemySystem::get_capacity() { return capacity; }
 
-    attraction.push_back(1000.0f);
-    radius.push_back(gGS.enemy_radius);
-    mass.push_back(1.0f);
-    max_vel.push_back(10.0f);
+void EnemySystem::set_capacity(int max_enemies) {
+  capacity = (std::max(max_enemies, 0) + SIMD_WIDTH - 1) / SIMD_WIDTH *
+             SIMD_WIDTH;
+  for_each_array([&](auto &array) { array.reserve(capacity); });
+  rope_stamp.reserve(capacity);
+  rope_candidates.reserve(capacity);
+}
 
-    count += 1;
-  }
+void EnemySystem::set_lifetime(float seconds) { lifetime = seconds; }
+
+void EnemySystem::set_despawn_distance(float distance) {
+  despawn_distance = distance;
 }
 
-void EnemySystem::update(Camera &camera, vector<float> &x_rope,
-                         vector<float> &y_rope) {
-  // spawn process
-  timer += DT;
-  if (timer >= spawn_time) {
-    timer = 0.0f;
+bool EnemySystem::add(EnemyType type, float x, float y) {
+  if (count >= capacity || type != EnemyType::Base)
+    return false;
 
-    SDL_FPoint p = camera.rand_point_in_view();
-    add(EnemyType::Base, p.x, p.y);
-  }
+  enemy_type.push_back(EnemyType::Base);
 
-  // physics process
-  for (int i = 0; i < count; i++) {
+  x_curr.push_back(x);
+  y_curr.push_back(y);
+  x_prev.push_back(x);
+  y_prev.push_back(y);
 
-    // main physics
-    SDL_FPoint attraction_vec = {x_rope[0] - x_curr[i], y_rope[0] - y_curr[i]};
-    float attraction_vec_mag = magnitude(attraction_vec);
-    SDL_FPoint attraction_dir = attraction_vec / attraction_vec_mag;
+  attraction.push_back(1000.0f);
+  radius.push_back(gGS.enemy_radius);
+  mass.push_back(1.0f);
+  max_vel.push_back(10.0f);
+  age.push_back(0.0f);
+  max_radius = std::max(max_radius, gGS.enemy_radius);
+  max_speed = std::max(max_speed, max_vel.back());
 
-    SDL_FPoint f = attraction[i] * attraction_dir;
+  count += 1;
+  grid_dirty = true;
+  return true;
+}
 
-    SDL_FPoint vel = {x_curr[i] - x_prev[i], y_curr[i] - y_prev[i]};
-    vel *= DAMPING;
+int EnemySystem::spawn_many(EnemyType type, const float *x, const float *y,
+                            int n) {
+  int added = 0;
+  while (added < n && add(type, x[added], y[added]))
+    added++;
+  return added;
+}
 
-    // clamp velocity to vel_mag
-    float vel_mag = magnitude(vel);
-    if (vel_mag > max_vel[i]) {
-      float ratio = max_vel[i] / vel_mag;
-      vel *= ratio;
-    }
+void EnemySystem::kill(int i) {
+  if (i >= 0 && i < count)
+    kill_list.push_back(i);
+}
 
-    SDL_FPoint f_drag = -AIR_RESISTANCE * vel;
-    f += f_drag;
+// Moves the last enemy into slot i, in every array at once.
+void EnemySystem::remove(int i) {
+  int last = count - 1;
+  for_each_array([&](auto &array) {
+    array[i] = array[last];
+    array.pop_back();
+  });
+  count -= 1;
+  grid_dirty = true;
+}
 
-    SDL_FPoint accel = f / mass[i];
+void EnemySystem::despawn(Camera &camera) {
+  SDL_FPoint center = camera.get_pos();
+  float max_dist2 = despawn_distance * despawn_distance;
+  for (int i = 0; i < count; i++) {
+    age[i] += DT;
+    float dx = x_curr[i] - center.x;
+    float dy = y_curr[i] - center.y;
+    float dist2 = dx * dx + dy * dy;
+    // a non-finite position fails every distance test, so drop it outright
+    if ((lifetime > 0.0f && age[i] >= lifetime) || !std::isfinite(dist2) ||
+        (despawn_distance > 0.0f && dist2 > max_dist2))
+      kill_list.push_back(i);
+  }
 
-    float x_new = x_curr[i] + vel.x + DT * DT * accel.x;
-    x_prev[i] = x_curr[i];
-    x_curr[i] = x_new;
+  // Highest index first: everything still queued is below i, so the enemy
+  // swapped in from the end is never one that is about to be removed.
+  std::sort(kill_list.begin(), kill_list.end(), std::greater<int>());
+  kill_list.erase(std::unique(kill_list.begin(), kill_list.end()),
+                  kill_list.end());
+  for (int i : kill_list)
+    remove(i);
+  kill_list.clear();
+}
 
-    float y_new = y_curr[i] + vel.y + DT * DT * accel.y;
-    y_prev[i] = y_curr[i];
-    y_curr[i] = y_new;
+void EnemySystem::spawn(Camera &camera, Uint64 &rng_state) {
+  timer += DT;
+  if (timer >= spawn_time) {
+    timer = 0.0f;
 
-    // collisions with ground
-    if (y_curr[i] >= gGS.winH - FLOOR_HEIGHT) {
-      float diff = y_curr[i] - (gGS.winH - FLOOR_HEIGHT);
-      y_curr[i] -= diff;
-    }
+    SDL_FPoint p = camera.rand_point_in_view(rng_state);
+    add(EnemyType::Base, p.x, p.y);
+  }
+}
 
-    for (int iter = 0; iter < 8; iter++) {
-      // collisions with rope
-      for (int j = 0; j < NUM_POINTS - 1; j++) {
-        // solve point inside circle
-        float x_diff = x_rope[j] - x_curr[i];
-        float y_diff = y_rope[j] - y_curr[i];
-        if (x_diff * x_diff + y_diff * y_diff <= radius[i] * radius[i]) {
-          SDL_FPoint n_vec = {x_diff, y_diff};
-          float n_mag = magnitude(n_vec);
-          SDL_FPoint normal = n_vec / n_mag;
-
-          SDL_FPoint correction = (radius[i] - n_mag) / 2.0f * normal;
-          x_rope[j] += correction.x;
-          y_rope[j] += correction.y;
-          x_curr[i] -= correction.x;
-          y_curr[i] -= correction.y;
+void EnemySystem::integrate(const RopePoints &rope) {
+  IntegrateArgs args;
+  args.x_curr = x_curr.data();
+  args.y_curr = y_curr.data();
+  args.x_prev = x_prev.data();
+  args.y_prev = y_prev.data();
+  args.attraction = attraction.data();
+  args.mass = mass.data();
+  args.max_vel = max_vel.data();
+  args.anchor_x = rope.x[0];
+  args.anchor_y = rope.y[0];
+  args.floor_y = gGS.winH - FLOOR_HEIGHT;
+
+  IntegrateKernel kernel = simd_integrate_kernel(simd_get_level());
+  job_pool().parallel_for(0, count, ENEMY_INTEGRATE_GRAIN,
+                          [&](int begin, int end) { kernel(args, begin, end); });
+  grid_dirty = true;
+}
+
+void EnemySystem::rebuild_grid() {
+  enemy_grid.rebuild(x_curr.data(), y_curr.data(), count);
+  grid_dirty = false;
+}
+
+void EnemySystem::collide_rope(const RopePoints &rope) {
+  // The rope is rope.points - 1 capsules; like before, the ball segment is
+  // left out. Segments only move by a fraction of a radius per iteration,
+  // so a box padded by twice the largest radius holds every enemy that can
+  // touch them this frame.
+  const int segments = rope.points - 2;
+  float pad = 2.0f * max_radius;
+
+  rope_x.resize(rope.points);
+  rope_y.resize(rope.points);
+  for (int j = 0; j < rope.points; j++) {
+    rope_x[j] = rope.x[j * rope.stride];
+    rope_y[j] = rope.y[j * rope.stride];
+  }
+  float *x_rope = rope_x.data();
+  float *y_rope = rope_y.data();
+
+  rope_stamp.resize(count, -1);
+  rope_candidates.clear();
+  rope_frame++;
+
+  for (int j = 0; j < segments; j++) {
+    int cx0, cy0, cx1, cy1;
+    if (!enemy_grid.cell_range(
+            std::min(x_rope[j], x_rope[j + 1]) - pad,
+            std::min(y_rope[j], y_rope[j + 1]) - pad,
+            std::max(x_rope[j], x_rope[j + 1]) + pad,
+            std::max(y_rope[j], y_rope[j + 1]) + pad, cx0, cy0, cx1, cy1))
+      continue;
+
+    for (int cy = cy0; cy <= cy1; cy++) {
+      for (int cx = cx0; cx <= cx1; cx++) {
+        const int *end = enemy_grid.cell_end(cx, cy);
+        for (const int *it = enemy_grid.cell_begin(cx, cy); it != end; ++it) {
+          if (rope_stamp[*it] == rope_frame)
+            continue;
+          rope_stamp[*it] = rope_frame;
+          rope_candidates.push_back(*it);
         }
       }
     }
   }
 
-  // clear grid
-  enemy_grid.clear();
+  // narrowphase: push each nearby enemy out of every segment capsule,
+  // splitting the rope's share of the correction between the segment's
+  // endpoints by where the contact lies along it
+  for (int i : rope_candidates) {
+    float r = radius[i];
+    for (int iter = 0; iter < ROPE_COLLISION_ITERATIONS; iter++) {
+      for (int j = 0; j < segments; j++) {
+        float sx = x_rope[j + 1] - x_rope[j];
+        float sy = y_rope[j + 1] - y_rope[j];
+        float len2 = sx * sx + sy * sy;
+        float t = 0.0f;
+        if (len2 > 1e-8f) {
+          t = ((x_curr[i] - x_rope[j]) * sx + (y_curr[i] - y_rope[j]) * sy) /
+              len2;
+          t = std::clamp(t, 0.0f, 1.0f);
+        }
 
-  // add all enemies to grid
-  for (int i = 0; i < count; i++) {
-    enemy_grid.add(x_curr[i], y_curr[i], i);
+        float x_diff = x_rope[j] + t * sx - x_curr[i];
+        float y_diff = y_rope[j] + t * sy - y_curr[i];
+        float d2 = x_diff * x_diff + y_diff * y_diff;
+        if (d2 > r * r || d2 < 1e-12f)
+          continue;
+
+        SDL_FPoint n_vec = {x_diff, y_diff};
+        float n_mag = magnitude(n_vec);
+        SDL_FPoint normal = n_vec / n_mag;
+
+        SDL_FPoint correction = (r - n_mag) / 2.0f * normal;
+        x_rope[j] += (1.0f - t) * correction.x;
+        y_rope[j] += (1.0f - t) * correction.y;
+        x_rope[j + 1] += t * correction.x;
+        y_rope[j + 1] += t * correction.y;
+        x_curr[i] -= correction.x;
+        y_curr[i] -= correction.y;
+      }
+    }
   }
 
-  // collisions with eachother
-  unordered_map<uint64_t, vector<int>> &grid = enemy_grid.get_grid();
-  for (int i = 0; i < count; ++i) {
-    int cx = (int)SDL_floorf(x_curr[i] / enemy_grid.get_cell_size());
-    int cy = (int)SDL_floorf(y_curr[i] / enemy_grid.get_cell_size());
+  if (rope_candidates.empty())
+    return;
+  for (int j = 0; j < rope.points; j++) {
+    rope.x[j * rope.stride] = x_rope[j];
+    rope.y[j * rope.stride] = y_rope[j];
+  }
+}
+
+// Resolves every enemy in cell (cx, cy) against the surrounding 3x3 block.
+// Only enemies in that block are read or written.
+void EnemySystem::collide_cell(int cx, int cy) {
+  int cols = enemy_grid.get_cols();
+  int rows = enemy_grid.get_rows();
 
+  const int *cell_end = enemy_grid.cell_end(cx, cy);
+  for (const int *ci = enemy_grid.cell_begin(cx, cy); ci != cell_end; ++ci) {
+    int i = *ci;
     for (int dy = -1; dy <= 1; ++dy) {
+      int ny = cy + dy;
+      if (ny < 0 || ny >= rows)
+        continue;
       for (int dx = -1; dx <= 1; ++dx) {
-        int nx = cx + dx, ny = cy + dy;
-        uint64_t key = (uint64_t)(uint32_t)nx << 32 | (uint32_t)ny;
-        auto it = grid.find(key);
-        if (it == grid.end())
+        int nx = cx + dx;
+        if (nx < 0 || nx >= cols)
           continue;
-        const vector<int> &bucket = it->second;
-        for (int j : bucket) {
+        const int *end = enemy_grid.cell_end(nx, ny);
+        for (const int *it = enemy_grid.cell_begin(nx, ny); it != end; ++it) {
+          int j = *it;
           if (j <= i)
             continue; // avoid double work
           //  check if points are touching
           SDL_FPoint vec = {x_curr[i] - x_curr[j], y_curr[i] - y_curr[j]};
           float dist = SDL_sqrt(vec.x * vec.x + vec.y * vec.y);
-          SDL_FPoint dir = vec / dist;
           float sum = radius[i] + radius[j];
           if (dist <= sum) {
+            // enemies on the same spot have no direction between them; part
+            // them along x
+            SDL_FPoint dir = dist > 0.0f ? vec / dist : SDL_FPoint{1.0f, 0.0f};
             float diff = sum - dist;
             SDL_FPoint correction = (diff * 0.5f) * dir;
 
@@ -165,9 +355,141 @@ void EnemySystem::update(Camera &camera, vector<float> &x_rope,
   }
 }
 
-void EnemySystem::draw(SDL_Renderer *renderer, Camera &camera) {
+// Cells are processed in nine colours by (cx % 3, cy % 3). Two cells of one
+// colour are three apart, so the 3x3 blocks they touch never overlap and a
+// colour's cells can run in any order, on any thread, with the same result.
+void EnemySystem::collide_enemies() {
+  int cols = enemy_grid.get_cols();
+  int rows = enemy_grid.get_rows();
+  // the grid never has fewer than GRID_MIN_CELLS cells, so with few enemies
+  // most chunks would be empty; don't wake the pool for those
+  int grain = count < ENEMY_INTEGRATE_GRAIN ? cols * rows : ENEMY_COLLIDE_GRAIN;
+
+  for (int color = 0; color < 9; color++) {
+    int ox = color % 3;
+    int oy = color / 3;
+    int color_cols = (cols - ox + 2) / 3;
+    int color_rows = (rows - oy + 2) / 3;
+    if (color_cols <= 0 || color_rows <= 0)
+      continue;
+
+    job_pool().parallel_for(
+        0, color_cols * color_rows, grain,
+        [&](int begin, int end) {
+          for (int k = begin; k < end; k++)
+            collide_cell(ox + 3 * (k % color_cols), oy + 3 * (k / color_cols));
+        });
+  }
+}
+
+void EnemySystem::update(Camera &camera, Uint64 &rng_state,
+                         const RopePoints &rope) {
+  despawn(camera);
+  spawn(camera, rng_state);
+
+  // physics process
+  integrate(rope);
+  rebuild_grid();
+  collide_rope(rope);
+
+  // collisions with eachother; the rope may have pushed some enemies into
+  // other cells
+  if (!rope_candidates.empty())
+    rebuild_grid();
+  collide_enemies();
+}
+
+void EnemySystem::resync() {
+  max_radius = 0.0f;
+  max_speed = 0.0f;
   for (int i = 0; i < count; i++) {
-    SDL_FPoint screen_pos = camera.worldToScreen({x_curr[i], y_curr[i]});
-    draw_circle(renderer, screen_pos.x, screen_pos.y, radius[i]);
+    max_radius = std::max(max_radius, radius[i]);
+    max_speed = std::max(max_speed, max_vel[i]);
+  }
+  grid_dirty = true;
+}
+
+const vector<int> &EnemySystem::cull(Camera &camera) {
+  // drawing interpolates both the camera and the enemies between steps
+  SDL_FRect view = camera.get_swept_view();
+  float min_x = view.x, min_y = view.y;
+  float max_x = view.x + view.w, max_y = view.y + view.h;
+  visible.clear();
+
+  auto test = [&](int i) {
+    float r = radius[i];
+    if (std::max(x_prev[i], x_curr[i]) + r >= min_x &&
+        std::min(x_prev[i], x_curr[i]) - r <= max_x &&
+        std::max(y_prev[i], y_curr[i]) + r >= min_y &&
+        std::min(y_prev[i], y_curr[i]) - r <= max_y)
+      visible.push_back(i);
+  };
+
+  // Before the first update, or after anything added, removed or moved
+  // enemies since the last rebuild, the grid doesn't describe the current
+  // enemies; test them all.
+  if (grid_dirty) {
+    for (int i = 0; i < count; i++)
+      test(i);
+    return visible;
+  }
+
+  // Enemies keep moving through collisions after the grid is rebuilt; one
+  // extra cell of padding covers that. x_prev trails the position the grid
+  // saw by at most max_speed.
+  float pad = max_radius + max_speed + enemy_grid.get_cell_size();
+  int cx0, cy0, cx1, cy1;
+  if (!enemy_grid.cell_range(min_x - pad, min_y - pad, max_x + pad,
+                             max_y + pad, cx0, cy0, cx1, cy1))
+    return visible;
+  for (int cy = cy0; cy <= cy1; cy++) {
+    // cells of a row are stored back to back, so one range covers the span
+    const int *end = enemy_grid.cell_end(cx1, cy);
+    for (const int *it = enemy_grid.cell_begin(cx0, cy); it != end; ++it)
+      test(*it);
+  }
+  return visible;
+}
+
+void EnemySystem::capture(Camera &camera, EnemyDrawList &out) {
+  cull(camera);
+  int n = (int)visible.size();
+  out.x_prev.resize(n);
+  out.y_prev.resize(n);
+  out.x_curr.resize(n);
+  out.y_curr.resize(n);
+  out.radius.resize(n);
+  for (int k = 0; k < n; k++) {
+    int i = visible[k];
+    out.x_prev[k] = x_prev[i];
+    out.y_prev[k] = y_prev[i];
+    out.x_curr[k] = x_curr[i];
+    out.y_curr[k] = y_curr[i];
+    out.radius[k] = radius[i];
   }
 }
+
+void EnemySystem::draw(SDL_Renderer *renderer, Camera &camera, float alpha) {
+  capture(camera, draw_list);
+  draw_list.draw(renderer, camera, alpha);
+}
+
+int EnemyDrawList::get_count() { return (int)radius.size(); }
+
+void EnemyDrawList::draw(SDL_Renderer *renderer, Camera &camera,
+                         float alpha) {
+  int n = (int)radius.size();
+  draw_x.resize(n);
+  draw_y.resize(n);
+  for (int k = 0; k < n; k++) {
+    draw_x[k] = x_prev[k] + (x_curr[k] - x_prev[k]) * alpha;
+    draw_y[k] = y_prev[k] + (y_curr[k] - y_prev[k]) * alpha;
+  }
+  screen_pos.resize(n);
+  camera.world_to_screen(draw_x.data(), draw_y.data(), screen_pos.data(), n);
+
+  SDL_FColor color = get_draw_color(renderer);
+  for (int k = 0; k < n; k++)
+    circle_batch.add(screen_pos[k].x, screen_pos[k].y, radius[k], color);
+  circle_batch.draw(renderer);
+}
@@ -0,0 +1,230 @@
+#include "enemy_simd.h"
+#include "utils.h"
+
+#include <SDL3/SDL.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||            \
+    defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX __attribute__((target("avx")))
+#else
+#define TARGET_AVX
+#endif
+#endif
+
+static SimdLevel active_level = SIMD_AUTO;
+
+void integrate_scalar(const IntegrateArgs &a, int begin, int end) {
+  for (int i = begin; i < end; i++) {
+    SDL_FPoint attraction_vec = {a.anchor_x - a.x_curr[i],
+                                 a.anchor_y - a.y_curr[i]};
+    float attraction_vec_mag = magnitude(attraction_vec);
+    // no pull on an enemy sitting exactly on the anchor; the vector kernels
+    // mask the same lanes to zero
+    SDL_FPoint f = {0.0f, 0.0f};
+    if (attraction_vec_mag > 0.0f)
+      f = a.attraction[i] * (attraction_vec / attraction_vec_mag);
+
+    SDL_FPoint vel = {a.x_curr[i] - a.x_prev[i], a.y_curr[i] - a.y_prev[i]};
+    vel *= DAMPING;
+
+    // clamp velocity to vel_mag
+    float vel_mag = magnitude(vel);
+    if (vel_mag > a.max_vel[i]) {
+      float ratio = a.max_vel[i] / vel_mag;
+      vel *= ratio;
+    }
+
+    SDL_FPoint f_drag = -AIR_RESISTANCE * vel;
+    f += f_drag;
+
+    SDL_FPoint accel = f / a.mass[i];
+
+    float x_new = a.x_curr[i] + vel.x + DT * DT * accel.x;
+    a.x_prev[i] = a.x_curr[i];
+    a.x_curr[i] = x_new;
+
+    float y_new = a.y_curr[i] + vel.y + DT * DT * accel.y;
+    a.y_prev[i] = a.y_curr[i];
+    a.y_curr[i] = y_new;
+
+    // collisions with ground
+    if (a.y_curr[i] >= a.floor_y) {
+      float diff = a.y_curr[i] - a.floor_y;
+      a.y_curr[i] -= diff;
+    }
+  }
+}
+
+#ifdef SIMD_X86
+
+static void integrate_sse2(const IntegrateArgs &a, int begin, int end) {
+  const __m128 anchor_x = _mm_set1_ps(a.anchor_x);
+  const __m128 anchor_y = _mm_set1_ps(a.anchor_y);
+  const __m128 damping = _mm_set1_ps(DAMPING);
+  const __m128 drag = _mm_set1_ps(-AIR_RESISTANCE);
+  const __m128 dt2 = _mm_set1_ps(DT * DT);
+  const __m128 floor_y = _mm_set1_ps(a.floor_y);
+
+  int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    __m128 x = _mm_loadu_ps(a.x_curr + i);
+    __m128 y = _mm_loadu_ps(a.y_curr + i);
+    __m128 xp = _mm_loadu_ps(a.x_prev + i);
+    __m128 yp = _mm_loadu_ps(a.y_prev + i);
+
+    __m128 ax = _mm_sub_ps(anchor_x, x);
+    __m128 ay = _mm_sub_ps(anchor_y, y);
+    __m128 amag =
+        _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ax, ax), _mm_mul_ps(ay, ay)));
+    __m128 attr = _mm_loadu_ps(a.attraction + i);
+    __m128 has_dir = _mm_cmpgt_ps(amag, _mm_setzero_ps());
+    __m128 fx = _mm_and_ps(has_dir, _mm_mul_ps(attr, _mm_div_ps(ax, amag)));
+    __m128 fy = _mm_and_ps(has_dir, _mm_mul_ps(attr, _mm_div_ps(ay, amag)));
+
+    __m128 vx = _mm_mul_ps(_mm_sub_ps(x, xp), damping);
+    __m128 vy = _mm_mul_ps(_mm_sub_ps(y, yp), damping);
+
+    __m128 vmag =
+        _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+    __m128 max_vel = _mm_loadu_ps(a.max_vel + i);
+    __m128 clamp = _mm_cmpgt_ps(vmag, max_vel);
+    __m128 ratio = _mm_div_ps(max_vel, vmag);
+    vx = _mm_or_ps(_mm_and_ps(clamp, _mm_mul_ps(vx, ratio)),
+                   _mm_andnot_ps(clamp, vx));
+    vy = _mm_or_ps(_mm_and_ps(clamp, _mm_mul_ps(vy, ratio)),
+                   _mm_andnot_ps(clamp, vy));
+
+    fx = _mm_add_ps(fx, _mm_mul_ps(drag, vx));
+    fy = _mm_add_ps(fy, _mm_mul_ps(drag, vy));
+
+    __m128 mass = _mm_loadu_ps(a.mass + i);
+    __m128 x_new = _mm_add_ps(_mm_add_ps(x, vx),
+                              _mm_mul_ps(dt2, _mm_div_ps(fx, mass)));
+    __m128 y_new = _mm_add_ps(_mm_add_ps(y, vy),
+                              _mm_mul_ps(dt2, _mm_div_ps(fy, mass)));
+
+    __m128 below = _mm_cmpge_ps(y_new, floor_y);
+    __m128 y_floor = _mm_sub_ps(y_new, _mm_sub_ps(y_new, floor_y));
+    y_new = _mm_or_ps(_mm_and_ps(below, y_floor), _mm_andnot_ps(below, y_new));
+
+    _mm_storeu_ps(a.x_prev + i, x);
+    _mm_storeu_ps(a.y_prev + i, y);
+    _mm_storeu_ps(a.x_curr + i, x_new);
+    _mm_storeu_ps(a.y_curr + i, y_new);
+  }
+
+  integrate_scalar(a, i, end);
+}
+
+TARGET_AVX static void integrate_avx(const IntegrateArgs &a, int begin,
+                                     int end) {
+  const __m256 anchor_x = _mm256_set1_ps(a.anchor_x);
+  const __m256 anchor_y = _mm256_set1_ps(a.anchor_y);
+  const __m256 damping = _mm256_set1_ps(DAMPING);
+  const __m256 drag = _mm256_set1_ps(-AIR_RESISTANCE);
+  const __m256 dt2 = _mm256_set1_ps(DT * DT);
+  const __m256 floor_y = _mm256_set1_ps(a.floor_y);
+
+  int i = begin;
+  for (; i + 8 <= end; i += 8) {
+    __m256 x = _mm256_loadu_ps(a.x_curr + i);
+    __m256 y = _mm256_loadu_ps(a.y_curr + i);
+    __m256 xp = _mm256_loadu_ps(a.x_prev + i);
+    __m256 yp = _mm256_loadu_ps(a.y_prev + i);
+
+    __m256 ax = _mm256_sub_ps(anchor_x, x);
+    __m256 ay = _mm256_sub_ps(anchor_y, y);
+    __m256 amag = _mm256_sqrt_ps(
+        _mm256_add_ps(_mm256_mul_ps(ax, ax), _mm256_mul_ps(ay, ay)));
+    __m256 attr = _mm256_loadu_ps(a.attraction + i);
+    __m256 has_dir = _mm256_cmp_ps(amag, _mm256_setzero_ps(), _CMP_GT_OQ);
+    __m256 fx =
+        _mm256_and_ps(has_dir, _mm256_mul_ps(attr, _mm256_div_ps(ax, amag)));
+    __m256 fy =
+        _mm256_and_ps(has_dir, _mm256_mul_ps(attr, _mm256_div_ps(ay, amag)));
+
+    __m256 vx = _mm256_mul_ps(_mm256_sub_ps(x, xp), damping);
+    __m256 vy = _mm256_mul_ps(_mm256_sub_ps(y, yp), damping);
+
+    __m256 vmag = _mm256_sqrt_ps(
+        _mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)));
+    __m256 max_vel = _mm256_loadu_ps(a.max_vel + i);
+    __m256 clamp = _mm256_cmp_ps(vmag, max_vel, _CMP_GT_OQ);
+    __m256 ratio = _mm256_div_ps(max_vel, vmag);
+    vx = _mm256_blendv_ps(vx, _mm256_mul_ps(vx, ratio), clamp);
+    vy = _mm256_blendv_ps(vy, _mm256_mul_ps(vy, ratio), clamp);
+
+    fx = _mm256_add_ps(fx, _mm256_mul_ps(drag, vx));
+    fy = _mm256_add_ps(fy, _mm256_mul_ps(drag, vy));
+
+    __m256 mass = _mm256_loadu_ps(a.mass + i);
+    __m256 x_new = _mm256_add_ps(_mm256_add_ps(x, vx),
+                                 _mm256_mul_ps(dt2, _mm256_div_ps(fx, mass)));
+    __m256 y_new = _mm256_add_ps(_mm256_add_ps(y, vy),
+                                 _mm256_mul_ps(dt2, _mm256_div_ps(fy, mass)));
+
+    __m256 below = _mm256_cmp_ps(y_new, floor_y, _CMP_GE_OQ);
+    __m256 y_floor = _mm256_sub_ps(y_new, _mm256_sub_ps(y_new, floor_y));
+    y_new = _mm256_blendv_ps(y_new, y_floor, below);
+
+    _mm256_storeu_ps(a.x_prev + i, x);
+    _mm256_storeu_ps(a.y_prev + i, y);
+    _mm256_storeu_ps(a.x_curr + i, x_new);
+    _mm256_storeu_ps(a.y_curr + i, y_new);
+  }
+
+  integrate_scalar(a, i, end);
+}
+
+#endif // SIMD_X86
+
+SimdLevel simd_detect() {
+#ifdef SIMD_X86
+  if (SDL_HasAVX())
+    return SIMD_AVX;
+  if (SDL_HasSSE2())
+    return SIMD_SSE2;
+#endif
+  return SIMD_SCALAR;
+}
+
+IntegrateKernel simd_integrate_kernel(SimdLevel level) {
+  SimdLevel best = simd_detect();
+  if (level == SIMD_AUTO || level > best)
+    level = best;
+
+  switch (level) {
+#ifdef SIMD_X86
+  case SIMD_AVX:
+    return integrate_avx;
+  case SIMD_SSE2:
+    return integrate_sse2;
+#endif
+  default:
+    return integrate_scalar;
+  }
+}
+
+const char *simd_level_name(SimdLevel level) {
+  switch (level) {
+  case SIMD_SCALAR:
+    return "scalar";
+  case SIMD_SSE2:
+    return "sse2";
+  case SIMD_AVX:
+    return "avx";
+  default:
+    return "auto";
+  }
+}
+
+void simd_set_level(SimdLevel level) { active_level = level; }
+
+SimdLevel simd_get_level() {
+  SimdLevel best = simd_detect();
+  return active_level == SIMD_AUTO || active_level > best ? best
+                                                          : active_level;
+}
@@ -0,0 +1,67 @@
+#include "frame_clock.h"
+
+#include <cmath>
+
+// Sleeps most of the way to deadline and spins the final FRAME_SPIN_NS.
+static void sleep_until(Uint64 deadline) {
+  Uint64 now = SDL_GetTicksNS();
+  if (deadline <= now)
+    return;
+  if (deadline - now > FRAME_SPIN_NS)
+    SDL_DelayNS(deadline - now - FRAME_SPIN_NS);
+  while (SDL_GetTicksNS() < deadline)
+    ;
+}
+
+FrameClock::FrameClock(float dt) {
+  step_ns = (Uint64)llround(dt * 1e9);
+  last = SDL_GetTicksNS();
+  accumulator = 0;
+  frame_ns = 0;
+  next_frame = last;
+  dropped = 0;
+}
+
+void FrameClock::set_max_fps(int fps) {
+  frame_ns = fps > 0 ? 1000000000ull / fps : 0;
+  next_frame = SDL_GetTicksNS();
+}
+
+int FrameClock::advance() {
+  Uint64 now = SDL_GetTicksNS();
+  accumulator += now - last;
+  last = now;
+
+  Uint64 steps = accumulator / step_ns;
+  if (steps > MAX_CATCHUP_STEPS) {
+    dropped += (int)(steps - MAX_CATCHUP_STEPS);
+    steps = MAX_CATCHUP_STEPS;
+    accumulator = steps * step_ns + accumulator % step_ns;
+  }
+  accumulator -= steps * step_ns;
+  return (int)steps;
+}
+
+float FrameClock::get_alpha() { return (float)accumulator / step_ns; }
+
+Uint64 FrameClock::get_step_time() { return last - accumulator; }
+
+Uint64 FrameClock::get_step_ns() { return step_ns; }
+
+int FrameClock::get_dropped_steps() { return dropped; }
+
+void FrameClock::wait() {
+  if (frame_ns == 0)
+    return;
+  next_frame += frame_ns;
+  Uint64 now = SDL_GetTicksNS();
+  if (next_frame <= now) {
+    // running late; start the next slot from now rather than rushing to
+    // make up the missed ones
+    next_frame = now;
+    return;
+  }
+  sleep_until(next_frame);
+}
+
+void FrameClock::wait_step() { sleep_until(last - accumulator + step_ns); }
@@ -1,3 +1,10 @@
 #include "globals.h"
 
-GameState gGS;
+GameState gGS = {
+    .winW = 1000,
+    .winH = 720,
+    .isDragging = false,
+    .altitude = 0,
+    .speed = 0.0f,
+    .enemy_radius = 10.0f,
+};
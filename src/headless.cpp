@@ -0,0 +1,118 @@
+#include "headless.h"
+#include "globals.h"
+#include "replay.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "state_hash.h"
+#include "utils.h"
+
+#include <cstdio>
+
+#define SCRIPT_DRAG_FRAMES 180
+#define SCRIPT_RELEASE_FRAMES 60
+#define SCRIPT_SWING_RADIUS 150.0f
+#define DEFAULT_HEADLESS_FRAMES 3600
+#define DEFAULT_HEADLESS_SEED 1
+
+SDL_FPoint scripted_mouse(int frame, bool &dragging) {
+  int phase = frame % (SCRIPT_DRAG_FRAMES + SCRIPT_RELEASE_FRAMES);
+  dragging = phase < SCRIPT_DRAG_FRAMES;
+
+  // one revolution every second while dragging, parked at the last point
+  // while released
+  int t = dragging ? phase : SCRIPT_DRAG_FRAMES;
+  float angle = t * DT * 2.0f * SDL_PI_F;
+
+  return {gGS.winW / 2.0f + SCRIPT_SWING_RADIUS * cosf(angle),
+          gGS.winH / 2.0f + SCRIPT_SWING_RADIUS * sinf(angle)};
+}
+
+void fast_forward(Simulation &sim, int frames) {
+  bool was_dragging = gGS.isDragging;
+  for (int frame = 0; frame < frames; ++frame) {
+    SDL_FPoint mouseScreen = scripted_mouse(frame, gGS.isDragging);
+    sim.step(sim.get_camera().screenToWorld(mouseScreen));
+  }
+  gGS.isDragging = was_dragging;
+}
+
+int run_headless(Options opts) {
+  Uint64 seed = opts.seed_set ? opts.seed : DEFAULT_HEADLESS_SEED;
+  int frames = opts.frames > 0 ? opts.frames : DEFAULT_HEADLESS_FRAMES;
+
+  InputReplay replay;
+  if (opts.replay_path) {
+    if (!replay.load(opts.replay_path))
+      return 1;
+    replay.apply_start_state(opts);
+    seed = replay.get_seed();
+    if (opts.frames <= 0 || opts.frames > replay.get_frame_count())
+      frames = replay.get_frame_count();
+  }
+
+  InputRecorder recorder;
+  if (opts.record_path && !recorder.open(opts.record_path, seed, opts))
+    return 1;
+
+  Simulation sim(seed);
+  sim.get_enemy_system().set_capacity(opts.max_enemies);
+  sim.get_enemy_system().set_lifetime(opts.enemy_lifetime);
+  sim.get_enemy_system().set_despawn_distance(opts.despawn_distance);
+  sim.set_rope_type(opts.rope_type);
+  sim.visit_rope([&](auto &rope) { rope.set_solver(opts.rope_solver); });
+  if (opts.snapshot_load_path && !load_snapshot(opts.snapshot_load_path, sim))
+    return 1;
+  fast_forward(sim, opts.fast_forward);
+
+  StateHashLog hash_log;
+  if (opts.hash_log_path && !hash_log.open(opts.hash_log_path, sim))
+    return 1;
+
+  Uint64 freq = SDL_GetPerformanceFrequency();
+  Uint64 total = 0;
+  Uint64 worst = 0;
+
+  if (!opts.quiet)
+    printf("frame,enemies,sim_ms\n");
+
+  for (int frame = 0; frame < frames; ++frame) {
+    AnchorPath mouseWorld = {};
+    if (opts.replay_path) {
+      const FrameInput &input = replay.next();
+      apply_frame_input(input);
+      mouseWorld = input.mouseWorld;
+    } else {
+      SDL_FPoint mouseScreen = scripted_mouse(frame, gGS.isDragging);
+      mouseWorld.points[0] = sim.get_camera().screenToWorld(mouseScreen);
+      mouseWorld.count = 1;
+    }
+    recorder.write(capture_frame_input(mouseWorld));
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    sim.step(mouseWorld);
+    Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+
+    hash_log.write(frame, sim);
+
+    total += elapsed;
+    if (elapsed > worst)
+      worst = elapsed;
+
+    if (!opts.quiet)
+      printf("%d,%d,%.4f\n", frame, sim.get_enemy_system().get_count(),
+             elapsed * 1000.0 / freq);
+  }
+
+  double total_ms = total * 1000.0 / freq;
+  printf("frames: %d\n", frames);
+  printf("enemies: %d\n", sim.get_enemy_system().get_count());
+  printf("total sim: %.3f ms\n", total_ms);
+  printf("avg frame: %.4f ms\n", total_ms / frames);
+  printf("worst frame: %.4f ms\n", worst * 1000.0 / freq);
+  printf("throughput: %.1f frames/s\n", frames / (total_ms / 1000.0));
+
+  if (opts.snapshot_save_path && !save_snapshot(opts.snapshot_save_path, sim))
+    return 1;
+
+  return 0;
+}
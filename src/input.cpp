@@ -0,0 +1,72 @@
+#include "input.h"
+
+#include <algorithm>
+
+MouseSampler::MouseSampler() { last = {SDL_GetTicksNS(), 0.0f, 0.0f}; }
+
+void MouseSampler::push(Uint64 time, float x, float y) {
+  lock_guard<mutex> lk(lock);
+  // keep the timeline monotonic whatever the event timestamps do
+  Uint64 newest = samples.empty() ? last.time : samples.back().time;
+  samples.push_back({std::max(time, newest), x, y});
+  if (samples.size() > MOUSE_SAMPLE_CAPACITY) {
+    last = samples.front();
+    samples.pop_front();
+  }
+}
+
+int MouseSampler::take_path(Uint64 until, SDL_FPoint *out, int n,
+                            Uint64 &input_time) {
+  lock_guard<mutex> lk(lock);
+  Uint64 newest = samples.empty() ? last.time : samples.back().time;
+  Uint64 start = last.time;
+  Uint64 end = std::max(std::min(until, newest), start);
+
+  // no more points than the mouse reported, so a slow or still mouse
+  // doesn't cost the rope a solve per repeated point
+  int arrived = 0;
+  while (arrived < n && arrived < (int)samples.size() &&
+         samples[arrived].time <= end)
+    ++arrived;
+  n = std::max(arrived, 1);
+
+  // walk the samples once, interpolating between the pair around each
+  // point's time
+  MouseSample a = last;
+  size_t next = 0;
+  for (int k = 1; k <= n; ++k) {
+    Uint64 t = start + (end - start) * k / n;
+    while (next < samples.size() && samples[next].time <= t)
+      a = samples[next++];
+    if (next < samples.size() && samples[next].time > a.time) {
+      const MouseSample &b = samples[next];
+      float f = (float)(t - a.time) / (float)(b.time - a.time);
+      out[k - 1] = {a.x + (b.x - a.x) * f, a.y + (b.y - a.y) * f};
+    } else {
+      out[k - 1] = {a.x, a.y};
+    }
+  }
+
+  samples.erase(samples.begin(), samples.begin() + next);
+  last = {end, out[n - 1].x, out[n - 1].y};
+  if (end > start)
+    input_time = end;
+  return n;
+}
+
+LatencyMeter::LatencyMeter() : count(0), next(0) {}
+
+void LatencyMeter::add(Uint64 input_time, Uint64 shown_time) {
+  history[next] = shown_time > input_time ? shown_time - input_time : 0;
+  next = (next + 1) % LATENCY_HISTORY;
+  count = std::min(count + 1, LATENCY_HISTORY);
+}
+
+float LatencyMeter::get_ms() {
+  if (count == 0)
+    return -1.0f;
+  Uint64 total = 0;
+  for (int i = 0; i < count; ++i)
+    total += history[i];
+  return (float)total / count / 1e6f;
+}
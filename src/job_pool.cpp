@@ -0,0 +1,122 @@
+#include "job_pool.h"
+#include "profiler.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+
+static int requested_threads = 0;
+static unique_ptr<JobPool> shared_pool;
+
+JobPool::JobPool(int threads) : queued(0), pending(0), quit(false) {
+  threads = std::max(threads, 1);
+  for (int i = 0; i < threads; i++)
+    queues.push_back(make_unique<Queue>());
+  for (int i = 1; i < threads; i++)
+    workers.emplace_back(&JobPool::worker_main, this, i);
+}
+
+JobPool::~JobPool() {
+  {
+    lock_guard<mutex> lk(sleep_lock);
+    quit = true;
+  }
+  wake.notify_all();
+  for (thread &t : workers)
+    t.join();
+}
+
+int JobPool::get_thread_count() const { return (int)queues.size(); }
+
+bool JobPool::pop(int self, Job &job) {
+  int n = (int)queues.size();
+  for (int k = 0; k < n; k++) {
+    Queue &q = *queues[(self + k) % n];
+    lock_guard<mutex> lk(q.lock);
+    if (q.jobs.empty())
+      continue;
+    if (k == 0) {
+      job = q.jobs.back();
+      q.jobs.pop_back();
+    } else {
+      job = q.jobs.front();
+      q.jobs.pop_front();
+    }
+    queued--;
+    return true;
+  }
+  return false;
+}
+
+void JobPool::run(const Job &job) {
+  PROFILE_ZONE("job");
+  (*job.fn)(job.begin, job.end);
+  pending--;
+}
+
+void JobPool::worker_main(int self) {
+  for (;;) {
+    Job job;
+    if (pop(self, job)) {
+      run(job);
+      continue;
+    }
+    unique_lock<mutex> lk(sleep_lock);
+    wake.wait(lk, [&] { return quit || queued > 0; });
+    if (quit)
+      return;
+  }
+}
+
+void JobPool::parallel_for(int begin, int end, int grain, const JobRange &fn) {
+  if (end <= begin)
+    return;
+  grain = std::max(grain, 1);
+  if (queues.size() == 1 || end - begin <= grain) {
+    fn(begin, end);
+    return;
+  }
+
+  int chunks = (end - begin + grain - 1) / grain;
+  pending = chunks;
+  int n = (int)queues.size();
+  for (int c = 0; c < chunks; c++) {
+    Queue &q = *queues[c % n];
+    lock_guard<mutex> lk(q.lock);
+    int b = begin + c * grain;
+    q.jobs.push_back({&fn, b, std::min(b + grain, end)});
+  }
+  {
+    lock_guard<mutex> lk(sleep_lock);
+    queued += chunks;
+  }
+  wake.notify_all();
+
+  // help out until every chunk is done, including ones still running on
+  // other threads
+  while (pending > 0) {
+    Job job;
+    if (pop(0, job))
+      run(job);
+    else
+      this_thread::yield();
+  }
+}
+
+void job_pool_set_threads(int threads) {
+  requested_threads = std::max(threads, 0);
+}
+
+int job_pool_get_threads() {
+  if (requested_threads > 0)
+    return requested_threads;
+  // the core count is a system query; job_pool() asks on every loop
+  static int cores = std::max(SDL_GetNumLogicalCPUCores(), 1);
+  return cores;
+}
+
+JobPool &job_pool() {
+  int threads = job_pool_get_threads();
+  if (!shared_pool || shared_pool->get_thread_count() != threads)
+    shared_pool = make_unique<JobPool>(threads);
+  return *shared_pool;
+}
@@ -0,0 +1,268 @@
+#include "json.h"
+
+#include <SDL3/SDL.h>
+
+#include <cstdlib>
+#include <cstring>
+
+#define JSON_MAX_DEPTH 256
+
+typedef struct {
+  const char *p;
+  const char *end;
+  const char *start;
+  string error;
+} JsonParser;
+
+static bool fail(JsonParser &ps, const char *what) {
+  if (ps.error.empty()) {
+    int line = 1;
+    for (const char *c = ps.start; c < ps.p; c++)
+      line += *c == '\n';
+    ps.error = string(what) + " on line " + to_string(line);
+  }
+  return false;
+}
+
+static void skip_space(JsonParser &ps) {
+  while (ps.p < ps.end &&
+         (*ps.p == ' ' || *ps.p == '\t' || *ps.p == '\n' || *ps.p == '\r'))
+    ps.p++;
+}
+
+static bool literal(JsonParser &ps, const char *word) {
+  size_t n = strlen(word);
+  if ((size_t)(ps.end - ps.p) < n || memcmp(ps.p, word, n) != 0)
+    return false;
+  ps.p += n;
+  return true;
+}
+
+static int hex_digit(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+static void append_utf8(string &out, Uint32 cp) {
+  if (cp < 0x80) {
+    out += (char)cp;
+  } else if (cp < 0x800) {
+    out += (char)(0xc0 | (cp >> 6));
+    out += (char)(0x80 | (cp & 0x3f));
+  } else if (cp < 0x10000) {
+    out += (char)(0xe0 | (cp >> 12));
+    out += (char)(0x80 | ((cp >> 6) & 0x3f));
+    out += (char)(0x80 | (cp & 0x3f));
+  } else {
+    out += (char)(0xf0 | (cp >> 18));
+    out += (char)(0x80 | ((cp >> 12) & 0x3f));
+    out += (char)(0x80 | ((cp >> 6) & 0x3f));
+    out += (char)(0x80 | (cp & 0x3f));
+  }
+}
+
+static bool parse_hex4(JsonParser &ps, Uint32 &cp) {
+  if (ps.end - ps.p < 4)
+    return fail(ps, "truncated \\u escape");
+  cp = 0;
+  for (int i = 0; i < 4; i++) {
+    int d = hex_digit(*ps.p++);
+    if (d < 0)
+      return fail(ps, "bad \\u escape");
+    cp = cp * 16 + d;
+  }
+  return true;
+}
+
+static bool parse_string(JsonParser &ps, string &out) {
+  ps.p++; // opening quote
+  while (ps.p < ps.end && *ps.p != '"') {
+    char c = *ps.p++;
+    if (c != '\\') {
+      out += c;
+      continue;
+    }
+    if (ps.p >= ps.end)
+      break;
+    switch (*ps.p++) {
+    case '"': out += '"'; break;
+    case '\\': out += '\\'; break;
+    case '/': out += '/'; break;
+    case 'b': out += '\b'; break;
+    case 'f': out += '\f'; break;
+    case 'n': out += '\n'; break;
+    case 'r': out += '\r'; break;
+    case 't': out += '\t'; break;
+    case 'u': {
+      Uint32 cp;
+      if (!parse_hex4(ps, cp))
+        return false;
+      // surrogate pair
+      if (cp >= 0xd800 && cp < 0xdc00 && literal(ps, "\\u")) {
+        Uint32 low;
+        if (!parse_hex4(ps, low))
+          return false;
+        cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+      }
+      append_utf8(out, cp);
+      break;
+    }
+    default:
+      return fail(ps, "bad escape in string");
+    }
+  }
+  if (ps.p >= ps.end)
+    return fail(ps, "unterminated string");
+  ps.p++; // closing quote
+  return true;
+}
+
+static bool parse_value(JsonParser &ps, JsonValue &out, int depth);
+
+static bool parse_array(JsonParser &ps, JsonValue &out, int depth) {
+  out.type = JSON_ARRAY;
+  ps.p++; // [
+  skip_space(ps);
+  if (ps.p < ps.end && *ps.p == ']') {
+    ps.p++;
+    return true;
+  }
+  for (;;) {
+    out.items.emplace_back();
+    if (!parse_value(ps, out.items.back(), depth + 1))
+      return false;
+    skip_space(ps);
+    if (ps.p < ps.end && *ps.p == ',') {
+      ps.p++;
+      continue;
+    }
+    if (ps.p < ps.end && *ps.p == ']') {
+      ps.p++;
+      return true;
+    }
+    return fail(ps, "expected ',' or ']'");
+  }
+}
+
+static bool parse_object(JsonParser &ps, JsonValue &out, int depth) {
+  out.type = JSON_OBJECT;
+  ps.p++; // {
+  skip_space(ps);
+  if (ps.p < ps.end && *ps.p == '}') {
+    ps.p++;
+    return true;
+  }
+  for (;;) {
+    skip_space(ps);
+    if (ps.p >= ps.end || *ps.p != '"')
+      return fail(ps, "expected a member name");
+    out.members.emplace_back();
+    if (!parse_string(ps, out.members.back().first))
+      return false;
+    skip_space(ps);
+    if (ps.p >= ps.end || *ps.p != ':')
+      return fail(ps, "expected ':'");
+    ps.p++;
+    if (!parse_value(ps, out.members.back().second, depth + 1))
+      return false;
+    skip_space(ps);
+    if (ps.p < ps.end && *ps.p == ',') {
+      ps.p++;
+      continue;
+    }
+    if (ps.p < ps.end && *ps.p == '}') {
+      ps.p++;
+      return true;
+    }
+    return fail(ps, "expected ',' or '}'");
+  }
+}
+
+static bool parse_number(JsonParser &ps, JsonValue &out) {
+  // strtod needs a terminated string; numbers are short, so copy one out
+  char buf[64];
+  size_t n = 0;
+  while (ps.p + n < ps.end && n < sizeof(buf) - 1 && ps.p[n] != '\0' &&
+         strchr("+-0123456789.eE", ps.p[n]))
+    n++;
+  memcpy(buf, ps.p, n);
+  buf[n] = '\0';
+  char *stop;
+  out.number = strtod(buf, &stop);
+  if (n == 0 || stop != buf + n)
+    return fail(ps, "bad number");
+  out.type = JSON_NUMBER;
+  ps.p += n;
+  return true;
+}
+
+static bool parse_value(JsonParser &ps, JsonValue &out, int depth) {
+  if (depth > JSON_MAX_DEPTH)
+    return fail(ps, "nested too deeply");
+  skip_space(ps);
+  if (ps.p >= ps.end)
+    return fail(ps, "unexpected end of input");
+
+  switch (*ps.p) {
+  case '{':
+    return parse_object(ps, out, depth);
+  case '[':
+    return parse_array(ps, out, depth);
+  case '"':
+    out.type = JSON_STRING;
+    return parse_string(ps, out.str);
+  case 't':
+  case 'f':
+    out.type = JSON_BOOL;
+    out.boolean = *ps.p == 't';
+    if (literal(ps, "true") || literal(ps, "false"))
+      return true;
+    return fail(ps, "unexpected token");
+  case 'n':
+    if (literal(ps, "null"))
+      return true;
+    return fail(ps, "unexpected token");
+  default:
+    return parse_number(ps, out);
+  }
+}
+
+bool json_parse(const char *text, size_t len, JsonValue &out, string &error) {
+  JsonParser ps = {text, text + len, text, ""};
+  out = JsonValue();
+  bool ok = parse_value(ps, out, 0);
+  if (ok) {
+    skip_space(ps);
+    if (ps.p != ps.end)
+      ok = fail(ps, "trailing characters after the document");
+  }
+  error = ps.error;
+  return ok;
+}
+
+const JsonValue *JsonValue::get(const char *key) const {
+  for (const auto &m : members)
+    if (m.first == key)
+      return &m.second;
+  return nullptr;
+}
+
+double JsonValue::get_number(const char *key, double fallback) const {
+  const JsonValue *v = get(key);
+  return v && v->type == JSON_NUMBER ? v->number : fallback;
+}
+
+bool JsonValue::get_bool(const char *key, bool fallback) const {
+  const JsonValue *v = get(key);
+  return v && v->type == JSON_BOOL ? v->boolean : fallback;
+}
+
+const char *JsonValue::get_string(const char *key, const char *fallback) const {
+  const JsonValue *v = get(key);
+  return v && v->type == JSON_STRING ? v->str.c_str() : fallback;
+}
@@ -3,86 +3,228 @@
 #include <string>
 
 #include "SDL3/SDL_init.h"
+#include "assets.h"
 #include "camera.h"
 #include "enemy.h"
+#include "frame_clock.h"
 #include "globals.h"
+#include "headless.h"
+#include "input.h"
+#include "options.h"
+#include "pack.h"
+#include "profiler.h"
+#include "replay.h"
 #include "rope.h"
+#include "sim_thread.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "state_hash.h"
+#include "tilemap.h"
 #include "ui.h"
 #include "world.h"
 
-int main(int, char **) {
+int main(int argc, char **argv) {
+  Options opts;
+  if (!parse_options(argc, argv, opts))
+    return 1;
+
+  if (opts.hash_compare[0])
+    return compare_hash_logs(opts.hash_compare[0], opts.hash_compare[1]);
+
+  if (opts.headless)
+    return run_headless(opts);
+
   if (!SDL_Init(SDL_INIT_VIDEO)) {
     SDL_Log("Failed to initialize SDL: %s", SDL_GetError());
     return 1;
   }
 
-  UI ui;
+  // decoding starts before the window exists; textures follow once a
+  // renderer is up, a budget's worth per frame
+  AssetPack pack;
+  if (opts.pack_path) {
+    if (!pack.open(opts.pack_path))
+      return 1;
+  } else if (SDL_GetPathInfo(PACK_DEFAULT_PATH, nullptr)) {
+    pack.open(PACK_DEFAULT_PATH);
+  }
+  AssetLoader assets(ASSET_LOADER_THREADS);
+  if (pack.is_open())
+    assets.mount(&pack);
+  UI ui(assets);
+
+  Uint64 seed = opts.seed_set ? opts.seed : SDL_GetPerformanceCounter();
+
+  InputReplay replay;
+  if (opts.replay_path) {
+    if (!replay.load(opts.replay_path))
+      return 1;
+    replay.apply_start_state(opts);
+    seed = replay.get_seed();
+  }
 
-  gGS.winW = 1000;
-  gGS.winH = 720;
-  gGS.isDragging = false;
-  gGS.enemy_radius = 10.0f;
-  gGS.enemy_radius = 10.0f;
+  InputRecorder recorder;
+  if (opts.record_path && !recorder.open(opts.record_path, seed, opts))
+    return 1;
 
   SDL_Window *window = SDL_CreateWindow("Circle Follow", gGS.winW, gGS.winH,
                                         SDL_WINDOW_RESIZABLE);
   SDL_Renderer *renderer = SDL_CreateRenderer(window, nullptr);
 
-  Rope rope;
-  Background bg(renderer);
-  Camera camera;
-  EnemySystem enemy_system;
+  // The simulation steps at a fixed DT whatever the display does; frames
+  // are paced by vsync when it's on, and by the clock under --max-fps or
+  // when vsync isn't available.
+  FrameClock frame_clock(DT);
+  int max_fps = opts.max_fps;
+  if (opts.vsync && !SDL_SetRenderVSync(renderer, 1)) {
+    SDL_Log("VSync unavailable: %s", SDL_GetError());
+    if (max_fps == 0)
+      max_fps = (int)lroundf(1.0f / DT);
+  }
+  frame_clock.set_max_fps(max_fps);
+
+  Background bg(assets);
+  TileMap map;
+  map.set_loader(&assets);
+  if (opts.map_path && !map.open(opts.map_path, renderer))
+    return 1;
+  Simulation sim(seed);
+  sim.get_enemy_system().set_capacity(opts.max_enemies);
+  sim.get_enemy_system().set_lifetime(opts.enemy_lifetime);
+  sim.get_enemy_system().set_despawn_distance(opts.despawn_distance);
+  sim.set_rope_type(opts.rope_type);
+  sim.visit_rope([&](auto &rope) { rope.set_solver(opts.rope_solver); });
+  if (opts.snapshot_load_path) {
+    if (!load_snapshot(opts.snapshot_load_path, sim))
+      return 1;
+    SDL_SetWindowSize(window, gGS.winW, gGS.winH);
+  }
+  fast_forward(sim, opts.fast_forward);
+
+  const char *snapshot_path = opts.snapshot_save_path
+                                  ? opts.snapshot_save_path
+                                  : "slinger_snapshot.bin";
+
+  StateHashLog hash_log;
+  if (opts.hash_log_path && !hash_log.open(opts.hash_log_path, sim))
+    return 1;
+
+  // Steps run on their own thread and each one publishes a snapshot for
+  // this loop to draw, so a frame costs the longer of the two rather than
+  // both. Replays step here instead: they rewrite the window size the
+  // renderer reads.
+  SimThread sim_thread(sim, opts.replay_path ? &replay : nullptr,
+                       opts.record_path ? &recorder : nullptr,
+                       opts.hash_log_path ? &hash_log : nullptr);
+  bool pipelined = opts.pipeline && !opts.replay_path;
+  if (pipelined)
+    sim_thread.start();
+
+  // every mouse position goes to the simulation with its event time, and
+  // the first present showing input from a given moment measures latency
+  MouseSampler &mouse = sim_thread.get_mouse();
+  LatencyMeter latency;
+  Uint64 measured_input = 0;
 
   bool running = true;
-  int mouseX = 0, mouseY = 0;
+  int trace_count = 0;
 
   while (running) {
+    PROFILE_FRAME();
+
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
       if (event.type == SDL_EVENT_QUIT)
         running = false;
       else if (event.type == SDL_EVENT_MOUSE_MOTION) {
-        mouseX = event.motion.x;
-        mouseY = event.motion.y;
+        mouse.push(event.motion.timestamp, event.motion.x, event.motion.y);
       } else if (event.type == SDL_EVENT_MOUSE_BUTTON_DOWN) {
         if (event.button.button == SDL_BUTTON_LEFT) {
-          gGS.isDragging = true;
+          mouse.push(event.button.timestamp, event.button.x, event.button.y);
+          sim_thread.set_dragging(true);
         }
       } else if (event.type == SDL_EVENT_MOUSE_BUTTON_UP) {
         if (event.button.button == SDL_BUTTON_LEFT) {
-          gGS.isDragging = false;
+          mouse.push(event.button.timestamp, event.button.x, event.button.y);
+          sim_thread.set_dragging(false);
         }
       } else if (event.type == SDL_EVENT_WINDOW_RESIZED) {
+        auto paused = sim_thread.pause();
         gGS.winW = event.window.data1;
         gGS.winH = event.window.data2;
+      } else if (event.type == SDL_EVENT_KEY_DOWN && !event.key.repeat) {
+        if (event.key.key == SDLK_F2) {
+          std::string path =
+              "slinger_trace_" + std::to_string(trace_count++) + ".json";
+          profiler_dump_chrome_trace(path.c_str());
+        } else if (event.key.key == SDLK_F3) {
+          ui.toggle_profiler();
+        } else if (event.key.key == SDLK_F5) {
+          auto paused = sim_thread.pause();
+          save_snapshot(snapshot_path, sim);
+        } else if (event.key.key == SDLK_F9) {
+          auto paused = sim_thread.pause();
+          if (load_snapshot(snapshot_path, sim))
+            SDL_SetWindowSize(window, gGS.winW, gGS.winH);
+        }
       }
     }
 
-    SDL_FPoint mouseScreen = {(float)mouseX, (float)mouseY};
-    SDL_FPoint mouseWorld = camera.screenToWorld(mouseScreen);
+    if (!pipelined)
+      sim_thread.tick();
+    if (sim_thread.finished())
+      break;
 
-    rope.update(mouseWorld);
-    camera.update(rope.get_anchor(), rope.get_end());
-    enemy_system.update(camera, rope.get_x(), rope.get_y());
+    // draw between the last two steps, by how far real time is into the
+    // next one
+    RenderSnapshot &snapshot = *sim_thread.latest();
+    float alpha = sim_thread.get_alpha(snapshot);
+    Camera view = snapshot.camera.interpolated(alpha);
 
-    gGS.altitude = rope.get_altitude();
-    gGS.speed = rope.get_speed();
+    if (assets.busy()) {
+      PROFILE_ZONE("assets.upload");
+      assets.upload(renderer, ASSET_UPLOAD_BUDGET);
+    }
 
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
     SDL_RenderClear(renderer);
 
     SDL_SetRenderDrawColor(renderer, 200, 80, 80, 255);
 
-    bg.draw(renderer, camera);
-    rope.draw(renderer, camera);
-    enemy_system.draw(renderer, camera);
-    ui.draw(renderer);
-
-    SDL_RenderPresent(renderer);
+    {
+      PROFILE_ZONE("bg.draw");
+      bg.draw(renderer, view);
+    }
+    {
+      PROFILE_ZONE("map.draw");
+      map.stream(view);
+      map.draw(renderer, view);
+    }
+    {
+      PROFILE_ZONE("rope.draw");
+      snapshot.rope.draw(renderer, view, alpha);
+    }
+    {
+      PROFILE_ZONE("enemy_system.draw");
+      snapshot.enemies.draw(renderer, view, alpha);
+    }
+    {
+      PROFILE_ZONE("ui.draw");
+      ui.draw(renderer, snapshot.altitude, snapshot.speed, latency.get_ms());
+    }
+    {
+      PROFILE_ZONE("SDL_RenderPresent");
+      SDL_RenderPresent(renderer);
+    }
+    if (snapshot.input_time > measured_input) {
+      latency.add(snapshot.input_time, SDL_GetTicksNS());
+      measured_input = snapshot.input_time;
+    }
 
-    SDL_Delay(16); // ~60fps
+    frame_clock.wait();
   }
 
+  sim_thread.stop();
   SDL_DestroyRenderer(renderer);
   SDL_DestroyWindow(window);
   SDL_Quit();
@@ -0,0 +1,53 @@
+#include "mapped_file.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : data(nullptr), size(0), mapped(false) {}
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const char *path) {
+  close();
+#ifndef _WIN32
+  int fd = ::open(path, O_RDONLY);
+  if (fd >= 0) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        data = p;
+        size = st.st_size;
+        mapped = true;
+      }
+    }
+    ::close(fd);
+    if (mapped)
+      return true;
+  }
+#endif
+  data = SDL_LoadFile(path, &size);
+  return data != nullptr;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+  if (mapped)
+    munmap(data, size);
+  else
+#endif
+    SDL_free(data);
+  data = nullptr;
+  size = 0;
+  mapped = false;
+}
+
+const Uint8 *MappedFile::bytes() const { return (const Uint8 *)data; }
+
+size_t MappedFile::get_size() const { return size; }
+
+bool MappedFile::is_mapped() const { return mapped; }
@@ -0,0 +1,213 @@
+#include "options.h"
+#include "enemy.h"
+#include "enemy_simd.h"
+#include "job_pool.h"
+#include "rope_registry.h"
+
+#include <SDL3/SDL.h>
+#include <cstdlib>
+#include <cstring>
+
+static void print_usage(const char *exe) {
+  SDL_Log("usage: %s [--headless] [--frames N] [--quiet] [--seed N]", exe);
+  SDL_Log("          [--record FILE] [--replay FILE] [--hash-log FILE]");
+  SDL_Log("          [--hash-compare A B] [--snapshot-load FILE]");
+  SDL_Log("          [--snapshot-save FILE] [--fast-forward N]");
+  SDL_Log("          [--simd auto|scalar|sse2|avx] [--threads N]");
+  SDL_Log("          [--max-enemies N] [--enemy-lifetime SECONDS]");
+  SDL_Log("          [--despawn-distance PIXELS]");
+  SDL_Log("          [--rope TYPE] [--rope-solver legacy|xpbd|direct]");
+  SDL_Log("          [--map FILE] [--pack FILE]");
+  SDL_Log("          [--vsync on|off] [--max-fps N] [--pipeline on|off]");
+  SDL_Log("  --headless     step the simulation without a window or renderer");
+  SDL_Log("  --frames N     frames to simulate headless (default 3600, or the");
+  SDL_Log("                 whole replay)");
+  SDL_Log("  --quiet        only print the headless summary, not every frame");
+  SDL_Log("  --seed N       spawn RNG seed (default: clock, 1 when headless)");
+  SDL_Log("  --record FILE  write every frame's input to FILE");
+  SDL_Log("  --replay FILE  drive the simulation from a recording");
+  SDL_Log("  --hash-log FILE");
+  SDL_Log("                 write a hash of every state field after each frame");
+  SDL_Log("  --hash-compare A B");
+  SDL_Log("                 report the first frame and fields where two hash");
+  SDL_Log("                 logs differ, then exit");
+  SDL_Log("  --snapshot-load FILE");
+  SDL_Log("                 start from a saved world instead of an empty one");
+  SDL_Log("  --snapshot-save FILE");
+  SDL_Log("                 headless: save the world after the last frame;");
+  SDL_Log("                 windowed: where F5 saves and F9 loads");
+  SDL_Log("  --fast-forward N");
+  SDL_Log("                 step N scripted frames before the window opens");
+  SDL_Log("  --simd LEVEL   enemy integration kernel (default auto: %s)",
+          simd_level_name(simd_detect()));
+  SDL_Log("  --threads N    worker threads for the enemy update, 1 = single");
+  SDL_Log("                 threaded (default 0: one per core, here %d)",
+          SDL_GetNumLogicalCPUCores());
+  SDL_Log("  --max-enemies N");
+  SDL_Log("                 hard cap on live enemies (default %d)",
+          ENEMY_DEFAULT_CAPACITY);
+  SDL_Log("  --enemy-lifetime SECONDS");
+  SDL_Log("                 despawn enemies after this long, 0 = never");
+  SDL_Log("                 (default %g)", ENEMY_DEFAULT_LIFETIME);
+  SDL_Log("  --despawn-distance PIXELS");
+  SDL_Log("                 despawn enemies this far from the camera centre,");
+  SDL_Log("                 0 = never (default %g)",
+          ENEMY_DEFAULT_DESPAWN_DISTANCE);
+  SDL_Log("  --rope TYPE    rope to play with: default, short or long");
+  SDL_Log("  --rope-solver SOLVER");
+  SDL_Log("                 rope constraint solver (default legacy)");
+  SDL_Log("  --map FILE     cooked map to stream in (slinger_cook map ...)");
+  SDL_Log("  --pack FILE    asset pack to load from (default assets.slpak when");
+  SDL_Log("                 present, loose files under assets/ otherwise)");
+  SDL_Log("  --vsync on|off present in step with the display (default on)");
+  SDL_Log("  --max-fps N    sleep between frames to stay under N fps,");
+  SDL_Log("                 0 = uncapped (default 0; the simulation always");
+  SDL_Log("                 steps at a fixed %g Hz)", 1.0 / DT);
+  SDL_Log("  --pipeline on|off");
+  SDL_Log("                 step the simulation on its own thread while the");
+  SDL_Log("                 last step is drawn (default on; replays always");
+  SDL_Log("                 step on the main thread)");
+}
+
+bool parse_options(int argc, char **argv, Options &opts) {
+  opts.headless = false;
+  opts.frames = 0;
+  opts.quiet = false;
+  opts.seed_set = false;
+  opts.seed = 0;
+  opts.record_path = nullptr;
+  opts.replay_path = nullptr;
+  opts.hash_log_path = nullptr;
+  opts.hash_compare[0] = nullptr;
+  opts.hash_compare[1] = nullptr;
+  opts.snapshot_load_path = nullptr;
+  opts.snapshot_save_path = nullptr;
+  opts.fast_forward = 0;
+  opts.simd = "auto";
+  opts.threads = 0;
+  opts.max_enemies = ENEMY_DEFAULT_CAPACITY;
+  opts.enemy_lifetime = ENEMY_DEFAULT_LIFETIME;
+  opts.despawn_distance = ENEMY_DEFAULT_DESPAWN_DISTANCE;
+  opts.rope_type = 0;
+  opts.rope_solver = ROPE_SOLVER_LEGACY;
+  opts.map_path = nullptr;
+  opts.pack_path = nullptr;
+  opts.vsync = true;
+  opts.max_fps = 0;
+  opts.pipeline = true;
+
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    if (strcmp(arg, "--headless") == 0) {
+      opts.headless = true;
+    } else if (strcmp(arg, "--frames") == 0 && i + 1 < argc) {
+      opts.frames = atoi(argv[++i]);
+      if (opts.frames <= 0) {
+        SDL_Log("--frames expects a positive frame count");
+        return false;
+      }
+    } else if (strcmp(arg, "--quiet") == 0) {
+      opts.quiet = true;
+    } else if (strcmp(arg, "--seed") == 0 && i + 1 < argc) {
+      opts.seed = strtoull(argv[++i], nullptr, 0);
+      opts.seed_set = true;
+    } else if (strcmp(arg, "--record") == 0 && i + 1 < argc) {
+      opts.record_path = argv[++i];
+    } else if (strcmp(arg, "--replay") == 0 && i + 1 < argc) {
+      opts.replay_path = argv[++i];
+    } else if (strcmp(arg, "--hash-log") == 0 && i + 1 < argc) {
+      opts.hash_log_path = argv[++i];
+    } else if (strcmp(arg, "--hash-compare") == 0 && i + 2 < argc) {
+      opts.hash_compare[0] = argv[++i];
+      opts.hash_compare[1] = argv[++i];
+    } else if (strcmp(arg, "--snapshot-load") == 0 && i + 1 < argc) {
+      opts.snapshot_load_path = argv[++i];
+    } else if (strcmp(arg, "--snapshot-save") == 0 && i + 1 < argc) {
+      opts.snapshot_save_path = argv[++i];
+    } else if (strcmp(arg, "--fast-forward") == 0 && i + 1 < argc) {
+      opts.fast_forward = atoi(argv[++i]);
+      if (opts.fast_forward < 0) {
+        SDL_Log("--fast-forward expects a frame count");
+        return false;
+      }
+    } else if (strcmp(arg, "--simd") == 0 && i + 1 < argc) {
+      opts.simd = argv[++i];
+      SimdLevel level = SIMD_AUTO;
+      for (int l = SIMD_AUTO; l <= SIMD_AVX; l++) {
+        if (strcmp(opts.simd, simd_level_name((SimdLevel)l)) == 0)
+          level = (SimdLevel)l;
+      }
+      if (level == SIMD_AUTO && strcmp(opts.simd, "auto") != 0) {
+        SDL_Log("--simd expects auto, scalar, sse2 or avx");
+        return false;
+      }
+      simd_set_level(level);
+    } else if (strcmp(arg, "--threads") == 0 && i + 1 < argc) {
+      opts.threads = atoi(argv[++i]);
+      if (opts.threads < 0) {
+        SDL_Log("--threads expects a thread count");
+        return false;
+      }
+      job_pool_set_threads(opts.threads);
+    } else if (strcmp(arg, "--max-enemies") == 0 && i + 1 < argc) {
+      opts.max_enemies = atoi(argv[++i]);
+      if (opts.max_enemies < 0) {
+        SDL_Log("--max-enemies expects an enemy count");
+        return false;
+      }
+    } else if (strcmp(arg, "--enemy-lifetime") == 0 && i + 1 < argc) {
+      opts.enemy_lifetime = (float)atof(argv[++i]);
+      if (opts.enemy_lifetime < 0.0f) {
+        SDL_Log("--enemy-lifetime expects seconds");
+        return false;
+      }
+    } else if (strcmp(arg, "--despawn-distance") == 0 && i + 1 < argc) {
+      opts.despawn_distance = (float)atof(argv[++i]);
+      if (opts.despawn_distance < 0.0f) {
+        SDL_Log("--despawn-distance expects a distance in pixels");
+        return false;
+      }
+    } else if (strcmp(arg, "--rope") == 0 && i + 1 < argc) {
+      if (!rope_type_from_name(argv[++i], opts.rope_type)) {
+        SDL_Log("--rope expects one of:");
+        for (int t = 0; t < rope_type_count(); t++)
+          SDL_Log("  %s", rope_type_name(t));
+        return false;
+      }
+    } else if (strcmp(arg, "--rope-solver") == 0 && i + 1 < argc) {
+      if (!rope_solver_from_name(argv[++i], opts.rope_solver)) {
+        SDL_Log("--rope-solver expects legacy, xpbd or direct");
+        return false;
+      }
+    } else if (strcmp(arg, "--map") == 0 && i + 1 < argc) {
+      opts.map_path = argv[++i];
+    } else if (strcmp(arg, "--pack") == 0 && i + 1 < argc) {
+      opts.pack_path = argv[++i];
+    } else if (strcmp(arg, "--vsync") == 0 && i + 1 < argc) {
+      const char *value = argv[++i];
+      if (strcmp(value, "on") != 0 && strcmp(value, "off") != 0) {
+        SDL_Log("--vsync expects on or off");
+        return false;
+      }
+      opts.vsync = strcmp(value, "on") == 0;
+    } else if (strcmp(arg, "--max-fps") == 0 && i + 1 < argc) {
+      opts.max_fps = atoi(argv[++i]);
+      if (opts.max_fps < 0) {
+        SDL_Log("--max-fps expects a frame rate");
+        return false;
+      }
+    } else if (strcmp(arg, "--pipeline") == 0 && i + 1 < argc) {
+      const char *value = argv[++i];
+      if (strcmp(value, "on") != 0 && strcmp(value, "off") != 0) {
+        SDL_Log("--pipeline expects on or off");
+        return false;
+      }
+      opts.pipeline = strcmp(value, "on") == 0;
+    } else {
+      SDL_Log("Unknown option: %s", arg);
+      print_usage(argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,94 @@
+#include "pack.h"
+
+#include <cstring>
+
+AssetPack::AssetPack() : entries(nullptr), entry_count(0) {}
+
+bool AssetPack::open(const char *path) {
+  close();
+  if (!file.open(path)) {
+    SDL_Log("Failed to open pack %s: %s", path, SDL_GetError());
+    return false;
+  }
+
+  PackHeader header;
+  size_t size = file.get_size();
+  bool ok = size >= sizeof(header);
+  if (ok)
+    memcpy(&header, file.bytes(), sizeof(header));
+  ok = ok && header.magic == PACK_MAGIC && header.version == PACK_VERSION &&
+       header.byte_order == PACK_BYTE_ORDER && header.file_size == size &&
+       sizeof(header) + (Uint64)header.entry_count * sizeof(PackEntry) <= size;
+  if (!ok) {
+    SDL_Log("%s is not a version %u pack for this machine", path,
+            PACK_VERSION);
+    close();
+    return false;
+  }
+
+  entries = (const PackEntry *)(file.bytes() + sizeof(header));
+  entry_count = header.entry_count;
+  for (Uint32 i = 0; i < entry_count; i++) {
+    const PackEntry &e = entries[i];
+    bool fits = e.offset <= size && e.size <= size - e.offset &&
+                memchr(e.path, '\0', PACK_PATH_LEN) != nullptr;
+    if (fits && e.kind == PACK_ENTRY_PIXELS)
+      fits = (Uint64)e.pitch * e.h <= e.size;
+    if (!fits) {
+      SDL_Log("%s: entry %u is out of bounds", path, i);
+      close();
+      return false;
+    }
+  }
+  SDL_Log("Mounted pack %s: %u entries, %zu bytes%s", path, entry_count, size,
+          file.is_mapped() ? "" : " (read, not mapped)");
+  return true;
+}
+
+void AssetPack::close() {
+  file.close();
+  entries = nullptr;
+  entry_count = 0;
+}
+
+bool AssetPack::is_open() { return entries != nullptr; }
+
+const PackEntry *AssetPack::find(const char *path) {
+  // entries are sorted by path
+  Uint32 lo = 0, hi = entry_count;
+  while (lo < hi) {
+    Uint32 mid = (lo + hi) / 2;
+    int cmp = strcmp(entries[mid].path, path);
+    if (cmp == 0)
+      return &entries[mid];
+    if (cmp < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return nullptr;
+}
+
+const void *AssetPack::data(const PackEntry &entry) {
+  return file.bytes() + entry.offset;
+}
+
+SDL_Texture *AssetPack::create_texture(SDL_Renderer *renderer,
+                                       const PackEntry &entry) {
+  SDL_Texture *texture =
+      SDL_CreateTexture(renderer, (SDL_PixelFormat)entry.format,
+                        SDL_TEXTUREACCESS_STATIC, entry.w, entry.h);
+  if (!texture)
+    return nullptr;
+  if (!SDL_UpdateTexture(texture, nullptr, data(entry), entry.pitch)) {
+    SDL_DestroyTexture(texture);
+    return nullptr;
+  }
+  // match what SDL_CreateTextureFromSurface does for an image with alpha
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+  return texture;
+}
+
+SDL_IOStream *AssetPack::open_io(const PackEntry &entry) {
+  return SDL_IOFromConstMem(data(entry), entry.size);
+}
@@ -0,0 +1,128 @@
+#include "pack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+static bool is_png(const char *path) {
+  size_t n = strlen(path);
+  return n >= 4 && SDL_strcasecmp(path + n - 4, ".png") == 0;
+}
+
+static Uint64 align_up(Uint64 v) {
+  return (v + PACK_ALIGN - 1) / PACK_ALIGN * PACK_ALIGN;
+}
+
+// Loads one input into its entry and the bytes to store for it.
+static bool read_input(const char *path, PackEntry &entry,
+                       vector<Uint8> &bytes) {
+  memset(&entry, 0, sizeof(entry));
+  if (strlen(path) >= PACK_PATH_LEN) {
+    SDL_Log("Asset path too long: %s", path);
+    return false;
+  }
+  SDL_strlcpy(entry.path, path, PACK_PATH_LEN);
+
+  if (!is_png(path)) {
+    size_t size;
+    void *data = SDL_LoadFile(path, &size);
+    if (!data) {
+      SDL_Log("Failed to read %s: %s", path, SDL_GetError());
+      return false;
+    }
+    entry.kind = PACK_ENTRY_BYTES;
+    bytes.assign((Uint8 *)data, (Uint8 *)data + size);
+    SDL_free(data);
+    return true;
+  }
+
+  SDL_Surface *loaded = SDL_LoadPNG(path);
+  if (!loaded) {
+    SDL_Log("Failed to load %s: %s", path, SDL_GetError());
+    return false;
+  }
+  SDL_Surface *rgba = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+  SDL_DestroySurface(loaded);
+  if (!rgba) {
+    SDL_Log("Failed to convert %s: %s", path, SDL_GetError());
+    return false;
+  }
+  entry.kind = PACK_ENTRY_PIXELS;
+  entry.format = SDL_PIXELFORMAT_RGBA32;
+  entry.w = rgba->w;
+  entry.h = rgba->h;
+  entry.pitch = rgba->w * 4; // tightly packed, whatever the surface used
+  bytes.resize((size_t)entry.pitch * entry.h);
+  for (int y = 0; y < rgba->h; y++)
+    memcpy(bytes.data() + (size_t)y * entry.pitch,
+           (const Uint8 *)rgba->pixels + (size_t)y * rgba->pitch, entry.pitch);
+  SDL_DestroySurface(rgba);
+  return true;
+}
+
+bool cook_asset_pack(const char *out_path, const char *const *inputs,
+                     int count) {
+  vector<const char *> paths(inputs, inputs + count);
+  std::sort(paths.begin(), paths.end(), [](const char *a, const char *b) {
+    return strcmp(a, b) < 0;
+  });
+  for (size_t i = 1; i < paths.size(); i++) {
+    if (strcmp(paths[i - 1], paths[i]) == 0) {
+      SDL_Log("%s is listed twice", paths[i]);
+      return false;
+    }
+  }
+
+  vector<PackEntry> entries(paths.size());
+  vector<vector<Uint8>> blobs(paths.size());
+  for (size_t i = 0; i < paths.size(); i++)
+    if (!read_input(paths[i], entries[i], blobs[i]))
+      return false;
+
+  PackHeader header = {};
+  header.magic = PACK_MAGIC;
+  header.version = PACK_VERSION;
+  header.byte_order = PACK_BYTE_ORDER;
+  header.entry_count = (Uint32)entries.size();
+  Uint64 offset = sizeof(header) + entries.size() * sizeof(PackEntry);
+  for (size_t i = 0; i < entries.size(); i++) {
+    offset = align_up(offset);
+    entries[i].offset = offset;
+    entries[i].size = blobs[i].size();
+    offset += blobs[i].size();
+  }
+  header.file_size = offset;
+
+  SDL_IOStream *io = SDL_IOFromFile(out_path, "wb");
+  if (!io) {
+    SDL_Log("Failed to open %s for writing: %s", out_path, SDL_GetError());
+    return false;
+  }
+  bool ok = SDL_WriteIO(io, &header, sizeof(header)) == sizeof(header);
+  ok = ok && SDL_WriteIO(io, entries.data(),
+                         entries.size() * sizeof(PackEntry)) ==
+                 entries.size() * sizeof(PackEntry);
+  Uint64 written = sizeof(header) + entries.size() * sizeof(PackEntry);
+  static const Uint8 zeros[PACK_ALIGN] = {};
+  for (size_t i = 0; i < entries.size() && ok; i++) {
+    size_t pad = (size_t)(entries[i].offset - written);
+    ok = SDL_WriteIO(io, zeros, pad) == pad &&
+         SDL_WriteIO(io, blobs[i].data(), blobs[i].size()) == blobs[i].size();
+    written = entries[i].offset + blobs[i].size();
+  }
+  ok = SDL_CloseIO(io) && ok;
+  if (!ok) {
+    SDL_Log("Failed to write %s", out_path);
+    return false;
+  }
+
+  for (const PackEntry &e : entries) {
+    if (e.kind == PACK_ENTRY_PIXELS)
+      SDL_Log("  %s: %u x %u RGBA", e.path, e.w, e.h);
+    else
+      SDL_Log("  %s: %llu bytes", e.path, (unsigned long long)e.size);
+  }
+  SDL_Log("Packed %zu assets into %s, %llu bytes", entries.size(), out_path,
+          (unsigned long long)header.file_size);
+  return true;
+}
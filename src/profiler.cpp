@@ -0,0 +1,141 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+// Rings are registered once per thread and never freed, so a dump still sees
+// samples from threads that have already exited.
+static mutex rings_mutex;
+static vector<ProfileRing *> rings;
+
+static float frame_history[PROFILER_FRAME_HISTORY];
+static int frame_count = 0;
+static Uint64 last_frame_mark = 0;
+
+ProfileRing::ProfileRing(int thread_id) : head(0), thread_id(thread_id) {
+  for (Slot &slot : slots)
+    slot.seq.store(0, memory_order_relaxed);
+}
+
+void ProfileRing::push(const char *name, Uint64 start, Uint64 end) {
+  Uint64 h = head.load(memory_order_relaxed);
+  Slot &slot = slots[h % PROFILER_RING_SIZE];
+  slot.seq.store(0, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  slot.name.store(name, memory_order_relaxed);
+  slot.start.store(start, memory_order_relaxed);
+  slot.end.store(end, memory_order_relaxed);
+  slot.seq.store(h + 1, memory_order_release);
+  head.store(h + 1, memory_order_release);
+}
+
+int ProfileRing::copy_out(ProfileSample *out, int max_samples) const {
+  Uint64 end = head.load(memory_order_acquire);
+  Uint64 n = std::min<Uint64>({end, (Uint64)PROFILER_RING_SIZE,
+                               (Uint64)max_samples});
+  int copied = 0;
+  for (Uint64 i = end - n; i < end; ++i) {
+    const Slot &slot = slots[i % PROFILER_RING_SIZE];
+    // skip slots the writer has lapped or is filling right now
+    if (slot.seq.load(memory_order_acquire) != i + 1)
+      continue;
+    ProfileSample sample = {slot.name.load(memory_order_relaxed),
+                            slot.start.load(memory_order_relaxed),
+                            slot.end.load(memory_order_relaxed)};
+    atomic_thread_fence(memory_order_acquire);
+    if (slot.seq.load(memory_order_relaxed) != i + 1)
+      continue;
+    out[copied++] = sample;
+  }
+  return copied;
+}
+
+int ProfileRing::get_thread_id() const { return thread_id; }
+
+static ProfileRing *thread_ring() {
+  thread_local ProfileRing *ring = nullptr;
+  if (!ring) {
+    lock_guard<mutex> lock(rings_mutex);
+    ring = new ProfileRing((int)rings.size());
+    rings.push_back(ring);
+  }
+  return ring;
+}
+
+void profiler_record(const char *name, Uint64 start, Uint64 end) {
+  thread_ring()->push(name, start, end);
+}
+
+void profiler_frame_mark() {
+  Uint64 now = SDL_GetPerformanceCounter();
+  if (last_frame_mark != 0) {
+    float ms = (float)((now - last_frame_mark) * 1000.0 /
+                       SDL_GetPerformanceFrequency());
+    frame_history[frame_count % PROFILER_FRAME_HISTORY] = ms;
+    frame_count++;
+  }
+  last_frame_mark = now;
+}
+
+int profiler_frame_history(float *out_ms, int max_frames) {
+  int n = std::min({frame_count, PROFILER_FRAME_HISTORY, max_frames});
+  int first = frame_count - n;
+  for (int i = 0; i < n; ++i)
+    out_ms[i] = frame_history[(first + i) % PROFILER_FRAME_HISTORY];
+  return n;
+}
+
+FrameStats profiler_frame_stats() {
+  FrameStats stats = {0.0f, 0.0f, 0.0f, 0.0f};
+
+  float sorted[PROFILER_FRAME_HISTORY];
+  int n = profiler_frame_history(sorted, PROFILER_FRAME_HISTORY);
+  if (n == 0)
+    return stats;
+
+  stats.last_ms = sorted[n - 1];
+  std::sort(sorted, sorted + n);
+  stats.p50_ms = sorted[n / 2];
+  stats.p99_ms = sorted[std::min(n - 1, (int)(n * 0.99f))];
+  stats.max_ms = sorted[n - 1];
+  return stats;
+}
+
+bool profiler_dump_chrome_trace(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    SDL_Log("Failed to open %s for writing", path);
+    return false;
+  }
+
+  double us_per_tick = 1e6 / SDL_GetPerformanceFrequency();
+  vector<ProfileSample> samples(PROFILER_RING_SIZE);
+
+  fprintf(f, "{\"traceEvents\":[\n");
+  bool first = true;
+  int total = 0;
+
+  lock_guard<mutex> lock(rings_mutex);
+  for (ProfileRing *ring : rings) {
+    int n = ring->copy_out(samples.data(), PROFILER_RING_SIZE);
+    for (int i = 0; i < n; ++i) {
+      const ProfileSample &s = samples[i];
+      fprintf(f,
+              "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,"
+              "\"ts\":%.3f,\"dur\":%.3f}",
+              first ? "" : ",\n", s.name, ring->get_thread_id(),
+              s.start * us_per_tick, (s.end - s.start) * us_per_tick);
+      first = false;
+    }
+    total += n;
+  }
+  fprintf(f, "\n]}\n");
+  fclose(f);
+
+  SDL_Log("Wrote %d profiler samples to %s", total, path);
+  return true;
+}
@@ -0,0 +1,223 @@
+#include "replay.h"
+#include "globals.h"
+#include "rope_registry.h"
+
+#include <cmath>
+#include <cstring>
+
+#define REPLAY_V2_HEADER_BYTES 28
+#define REPLAY_HEADER_BYTES 48
+// smallest frame: one path point
+#define REPLAY_V1_FRAME_BYTES 13
+#define REPLAY_FRAME_BYTES 14
+#define REPLAY_FLAG_DRAGGING 0x1
+
+static Uint32 float_bits(float f) {
+  Uint32 u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+static float bits_float(Uint32 u) {
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+InputRecorder::InputRecorder() {
+  io = nullptr;
+  frame_count = 0;
+}
+
+InputRecorder::~InputRecorder() { close(); }
+
+bool InputRecorder::open(const char *path, Uint64 seed, const Options &opts) {
+  io = SDL_IOFromFile(path, "wb");
+  if (!io) {
+    SDL_Log("Failed to open %s for recording: %s", path, SDL_GetError());
+    return false;
+  }
+
+  frame_count = 0;
+  SDL_WriteU32LE(io, REPLAY_MAGIC);
+  SDL_WriteU32LE(io, REPLAY_VERSION);
+  SDL_WriteU64LE(io, seed);
+  SDL_WriteU32LE(io, (Uint32)gGS.winW);
+  SDL_WriteU32LE(io, (Uint32)gGS.winH);
+  SDL_WriteU32LE(io, (Uint32)opts.rope_type);
+  SDL_WriteU32LE(io, (Uint32)opts.rope_solver);
+  SDL_WriteU32LE(io, (Uint32)opts.max_enemies);
+  SDL_WriteU32LE(io, float_bits(opts.enemy_lifetime));
+  SDL_WriteU32LE(io, float_bits(opts.despawn_distance));
+  SDL_WriteU32LE(io, 0); // frame count, patched in close()
+  return true;
+}
+
+void InputRecorder::write(const FrameInput &input) {
+  if (!io)
+    return;
+
+  const AnchorPath &path = input.mouseWorld;
+  SDL_WriteU8(io, (Uint8)path.count);
+  for (int k = 0; k < path.count; ++k) {
+    SDL_WriteU32LE(io, float_bits(path.points[k].x));
+    SDL_WriteU32LE(io, float_bits(path.points[k].y));
+  }
+  SDL_WriteU16LE(io, (Uint16)input.winW);
+  SDL_WriteU16LE(io, (Uint16)input.winH);
+  SDL_WriteU8(io, input.isDragging ? REPLAY_FLAG_DRAGGING : 0);
+  frame_count++;
+}
+
+void InputRecorder::close() {
+  if (!io)
+    return;
+
+  SDL_SeekIO(io, REPLAY_HEADER_BYTES - 4, SDL_IO_SEEK_SET);
+  SDL_WriteU32LE(io, frame_count);
+  SDL_CloseIO(io);
+  io = nullptr;
+  SDL_Log("Recorded %u frames", frame_count);
+}
+
+InputReplay::InputReplay() {
+  seed = 0;
+  start_w = 0;
+  start_h = 0;
+  has_settings = false;
+  settings = {};
+  cursor = 0;
+}
+
+InputReplay::~InputReplay() {}
+
+bool InputReplay::load(const char *path) {
+  size_t size = 0;
+  Uint8 *data = (Uint8 *)SDL_LoadFile(path, &size);
+  if (!data) {
+    SDL_Log("Failed to load replay %s: %s", path, SDL_GetError());
+    return false;
+  }
+
+  SDL_IOStream *io = SDL_IOFromConstMem(data, size);
+  Uint32 magic = 0, version = 0, w = 0, h = 0, count = 0;
+  Uint32 rope = 0, solver = 0, enemies = 0, lifetime = 0, despawn = 0;
+  bool ok = io && SDL_ReadU32LE(io, &magic) && SDL_ReadU32LE(io, &version) &&
+            SDL_ReadU64LE(io, &seed) && SDL_ReadU32LE(io, &w) &&
+            SDL_ReadU32LE(io, &h);
+  has_settings = version >= 3;
+  if (ok && has_settings) {
+    ok = SDL_ReadU32LE(io, &rope) && SDL_ReadU32LE(io, &solver) &&
+         SDL_ReadU32LE(io, &enemies) && SDL_ReadU32LE(io, &lifetime) &&
+         SDL_ReadU32LE(io, &despawn);
+    settings = {(int)rope, (RopeSolver)solver, (int)enemies,
+                bits_float(lifetime), bits_float(despawn)};
+    // the same ranges parse_options accepts
+    ok = ok && rope < (Uint32)rope_type_count() &&
+         solver <= ROPE_SOLVER_DIRECT && enemies <= INT32_MAX &&
+         std::isfinite(settings.enemy_lifetime) &&
+         settings.enemy_lifetime >= 0.0f &&
+         std::isfinite(settings.despawn_distance) &&
+         settings.despawn_distance >= 0.0f;
+  }
+  ok = ok && SDL_ReadU32LE(io, &count);
+  size_t header_bytes =
+      has_settings ? REPLAY_HEADER_BYTES : REPLAY_V2_HEADER_BYTES;
+  size_t frame_bytes =
+      version == 1 ? REPLAY_V1_FRAME_BYTES : REPLAY_FRAME_BYTES;
+  if (!ok || magic != REPLAY_MAGIC || version < 1 ||
+      version > REPLAY_VERSION ||
+      size < header_bytes + (size_t)count * frame_bytes) {
+    SDL_Log("%s is not a valid version %u replay", path, REPLAY_VERSION);
+    if (io)
+      SDL_CloseIO(io);
+    SDL_free(data);
+    return false;
+  }
+
+  start_w = (int)w;
+  start_h = (int)h;
+  frames.resize(count);
+  for (Uint32 i = 0; i < count && ok; ++i) {
+    AnchorPath &mouse = frames[i].mouseWorld;
+    Uint8 points = 1;
+    if (version != 1)
+      ok = SDL_ReadU8(io, &points) && points >= 1 &&
+           points <= ROPE_ANCHOR_SUBSTEPS;
+    mouse.count = points;
+    for (int k = 0; k < mouse.count && ok; ++k) {
+      Uint32 x, y;
+      ok = SDL_ReadU32LE(io, &x) && SDL_ReadU32LE(io, &y);
+      mouse.points[k] = {bits_float(x), bits_float(y)};
+    }
+    Uint16 fw, fh;
+    Uint8 flags;
+    ok = ok && SDL_ReadU16LE(io, &fw) && SDL_ReadU16LE(io, &fh) &&
+         SDL_ReadU8(io, &flags);
+    if (!ok)
+      break;
+    frames[i].winW = fw;
+    frames[i].winH = fh;
+    frames[i].isDragging = (flags & REPLAY_FLAG_DRAGGING) != 0;
+  }
+
+  SDL_CloseIO(io);
+  SDL_free(data);
+  if (!ok) {
+    SDL_Log("%s is truncated or has a bad anchor path", path);
+    frames.clear();
+    return false;
+  }
+  cursor = 0;
+  SDL_Log("Loaded replay %s: %u frames, seed %llu", path, count,
+          (unsigned long long)seed);
+  return true;
+}
+
+Uint64 InputReplay::get_seed() { return seed; }
+
+int InputReplay::get_frame_count() { return (int)frames.size(); }
+
+bool InputReplay::done() { return cursor >= frames.size(); }
+
+const FrameInput &InputReplay::next() { return frames[cursor++]; }
+
+void InputReplay::apply_start_state(Options &opts) {
+  gGS.winW = start_w;
+  gGS.winH = start_h;
+  if (!has_settings)
+    return;
+
+  if (opts.rope_type != settings.rope_type ||
+      opts.rope_solver != settings.rope_solver ||
+      opts.max_enemies != settings.max_enemies ||
+      opts.enemy_lifetime != settings.enemy_lifetime ||
+      opts.despawn_distance != settings.despawn_distance)
+    SDL_Log("Replaying with the recorded --rope %s --rope-solver %s "
+            "--max-enemies %d --enemy-lifetime %g --despawn-distance %g",
+            rope_type_name(settings.rope_type),
+            rope_solver_name(settings.rope_solver), settings.max_enemies,
+            settings.enemy_lifetime, settings.despawn_distance);
+  opts.rope_type = settings.rope_type;
+  opts.rope_solver = settings.rope_solver;
+  opts.max_enemies = settings.max_enemies;
+  opts.enemy_lifetime = settings.enemy_lifetime;
+  opts.despawn_distance = settings.despawn_distance;
+}
+
+FrameInput capture_frame_input(const AnchorPath &mouseWorld) {
+  return {mouseWorld, gGS.winW, gGS.winH, gGS.isDragging};
+}
+
+FrameInput capture_frame_input(SDL_FPoint mouseWorld) {
+  AnchorPath path = {};
+  path.points[0] = mouseWorld;
+  path.count = 1;
+  return capture_frame_input(path);
+}
+
+void apply_frame_input(const FrameInput &input) {
+  gGS.winW = input.winW;
+  gGS.winH = input.winH;
+  gGS.isDragging = input.isDragging;
+}
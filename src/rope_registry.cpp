@@ -0,0 +1,37 @@
+#include "rope_registry.h"
+
+#include <cstring>
+#include <utility>
+
+template <size_t... I>
+static const char *type_name(int type, index_sequence<I...>) {
+  const char *names[] = {variant_alternative_t<I, AnyRope>::name...};
+  return names[type];
+}
+
+template <size_t... I>
+static void emplace_type(AnyRope &rope, int type, index_sequence<I...>) {
+  ((type == (int)I ? (void)rope.template emplace<I>() : (void)0), ...);
+}
+
+int rope_type_count() { return (int)variant_size_v<AnyRope>; }
+
+const char *rope_type_name(int type) {
+  if (type < 0 || type >= rope_type_count())
+    return "unknown";
+  return type_name(type, make_index_sequence<variant_size_v<AnyRope>>());
+}
+
+bool rope_type_from_name(const char *name, int &type) {
+  for (int t = 0; t < rope_type_count(); t++) {
+    if (strcmp(name, rope_type_name(t)) == 0) {
+      type = t;
+      return true;
+    }
+  }
+  return false;
+}
+
+void make_rope(AnyRope &rope, int type) {
+  emplace_type(rope, type, make_index_sequence<variant_size_v<AnyRope>>());
+}
@@ -0,0 +1,24 @@
+#include "rope_solver.h"
+
+#include <cstring>
+
+const char *rope_solver_name(RopeSolver solver) {
+  switch (solver) {
+  case ROPE_SOLVER_XPBD:
+    return "xpbd";
+  case ROPE_SOLVER_DIRECT:
+    return "direct";
+  default:
+    return "legacy";
+  }
+}
+
+bool rope_solver_from_name(const char *name, RopeSolver &solver) {
+  for (int s = ROPE_SOLVER_LEGACY; s <= ROPE_SOLVER_DIRECT; s++) {
+    if (strcmp(name, rope_solver_name((RopeSolver)s)) == 0) {
+      solver = (RopeSolver)s;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,807 @@
+#include "rope_system.h"
+#include "globals.h"
+#include "rope_registry.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ROPE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// The solver blocks are written once against a lane type L: Lanes holds one
+// float per rope for ROPE_LANES ropes, OneLane a single rope. lanes_set and
+// lanes_load name the type they make; everything else is overloaded.
+template <typename L> static inline L lanes_set(float f);
+template <typename L> static inline L lanes_load(const float *p);
+// the per-lane condition comparisons on L give
+template <typename L> using LaneMaskOf = decltype(L() < L());
+
+// One float per rope for ROPE_LANES ropes, and a per-lane condition. With
+// SSE2 every operation is a single instruction; otherwise a plain loop. Both
+// do exactly the scalar IEEE operation in each lane (no FMA, no reciprocal
+// estimates).
+#ifdef ROPE_SSE2
+
+typedef struct {
+  __m128 v;
+} Lanes;
+
+typedef struct {
+  __m128 v;
+} LaneMask;
+
+template <> inline Lanes lanes_set<Lanes>(float f) { return {_mm_set1_ps(f)}; }
+template <> inline Lanes lanes_load<Lanes>(const float *p) {
+  return {_mm_load_ps(p)};
+}
+static inline void lanes_store(float *p, Lanes a) { _mm_store_ps(p, a.v); }
+static inline Lanes operator+(Lanes a, Lanes b) { return {_mm_add_ps(a.v, b.v)}; }
+static inline Lanes operator-(Lanes a, Lanes b) { return {_mm_sub_ps(a.v, b.v)}; }
+static inline Lanes operator*(Lanes a, Lanes b) { return {_mm_mul_ps(a.v, b.v)}; }
+static inline Lanes operator/(Lanes a, Lanes b) { return {_mm_div_ps(a.v, b.v)}; }
+static inline Lanes operator-(Lanes a) {
+  return {_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))};
+}
+static inline Lanes lanes_sqrt(Lanes a) { return {_mm_sqrt_ps(a.v)}; }
+static inline Lanes lanes_abs(Lanes a) {
+  return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)};
+}
+static inline LaneMask operator<(Lanes a, Lanes b) {
+  return {_mm_cmplt_ps(a.v, b.v)};
+}
+static inline LaneMask operator>(Lanes a, Lanes b) {
+  return {_mm_cmpgt_ps(a.v, b.v)};
+}
+static inline LaneMask operator>=(Lanes a, Lanes b) {
+  return {_mm_cmpge_ps(a.v, b.v)};
+}
+static inline LaneMask operator&(LaneMask a, LaneMask b) {
+  return {_mm_and_ps(a.v, b.v)};
+}
+static inline LaneMask operator|(LaneMask a, LaneMask b) {
+  return {_mm_or_ps(a.v, b.v)};
+}
+static inline LaneMask operator~(LaneMask a) {
+  return {_mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1)))};
+}
+// a where m is set, b elsewhere
+static inline Lanes select(LaneMask m, Lanes a, Lanes b) {
+  return {_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))};
+}
+static inline bool any(LaneMask m) { return _mm_movemask_ps(m.v) != 0; }
+static inline bool all(LaneMask m) { return _mm_movemask_ps(m.v) == 0xf; }
+
+#else
+
+typedef struct {
+  float v[ROPE_LANES];
+} Lanes;
+
+typedef struct {
+  bool v[ROPE_LANES];
+} LaneMask;
+
+#define LANES_MAP(T, expr)                                                     \
+  T out;                                                                       \
+  for (int l = 0; l < ROPE_LANES; l++)                                         \
+    out.v[l] = (expr);                                                         \
+  return out
+
+template <> inline Lanes lanes_set<Lanes>(float f) { LANES_MAP(Lanes, f); }
+template <> inline Lanes lanes_load<Lanes>(const float *p) {
+  LANES_MAP(Lanes, p[l]);
+}
+static inline void lanes_store(float *p, Lanes a) {
+  memcpy(p, a.v, sizeof(a.v));
+}
+static inline Lanes operator+(Lanes a, Lanes b) { LANES_MAP(Lanes, a.v[l] + b.v[l]); }
+static inline Lanes operator-(Lanes a, Lanes b) { LANES_MAP(Lanes, a.v[l] - b.v[l]); }
+static inline Lanes operator*(Lanes a, Lanes b) { LANES_MAP(Lanes, a.v[l] * b.v[l]); }
+static inline Lanes operator/(Lanes a, Lanes b) { LANES_MAP(Lanes, a.v[l] / b.v[l]); }
+static inline Lanes operator-(Lanes a) { LANES_MAP(Lanes, -a.v[l]); }
+static inline Lanes lanes_sqrt(Lanes a) { LANES_MAP(Lanes, sqrtf(a.v[l])); }
+static inline Lanes lanes_abs(Lanes a) { LANES_MAP(Lanes, fabsf(a.v[l])); }
+static inline LaneMask operator<(Lanes a, Lanes b) { LANES_MAP(LaneMask, a.v[l] < b.v[l]); }
+static inline LaneMask operator>(Lanes a, Lanes b) { LANES_MAP(LaneMask, a.v[l] > b.v[l]); }
+static inline LaneMask operator>=(Lanes a, Lanes b) { LANES_MAP(LaneMask, a.v[l] >= b.v[l]); }
+static inline LaneMask operator&(LaneMask a, LaneMask b) { LANES_MAP(LaneMask, a.v[l] && b.v[l]); }
+static inline LaneMask operator|(LaneMask a, LaneMask b) { LANES_MAP(LaneMask, a.v[l] || b.v[l]); }
+static inline LaneMask operator~(LaneMask a) { LANES_MAP(LaneMask, !a.v[l]); }
+static inline Lanes select(LaneMask m, Lanes a, Lanes b) {
+  LANES_MAP(Lanes, m.v[l] ? a.v[l] : b.v[l]);
+}
+static inline bool any(LaneMask m) {
+  for (int l = 0; l < ROPE_LANES; l++)
+    if (m.v[l])
+      return true;
+  return false;
+}
+static inline bool all(LaneMask m) { return !any(~m); }
+
+#undef LANES_MAP
+
+#endif // ROPE_SSE2
+
+// One rope on plain floats, for the ropes left over once the rest fill
+// groups of ROPE_LANES: the same operations as a single lane above, without
+// the idle lanes a partly filled group would carry.
+typedef struct {
+  float v;
+} OneLane;
+
+typedef struct {
+  bool v;
+} OneLaneMask;
+
+template <> inline OneLane lanes_set<OneLane>(float f) { return {f}; }
+template <> inline OneLane lanes_load<OneLane>(const float *p) { return {*p}; }
+static inline void lanes_store(float *p, OneLane a) { *p = a.v; }
+static inline OneLane operator+(OneLane a, OneLane b) { return {a.v + b.v}; }
+static inline OneLane operator-(OneLane a, OneLane b) { return {a.v - b.v}; }
+static inline OneLane operator*(OneLane a, OneLane b) { return {a.v * b.v}; }
+static inline OneLane operator/(OneLane a, OneLane b) { return {a.v / b.v}; }
+static inline OneLane operator-(OneLane a) { return {-a.v}; }
+static inline OneLane lanes_sqrt(OneLane a) { return {sqrtf(a.v)}; }
+static inline OneLane lanes_abs(OneLane a) { return {fabsf(a.v)}; }
+static inline OneLaneMask operator<(OneLane a, OneLane b) { return {a.v < b.v}; }
+static inline OneLaneMask operator>(OneLane a, OneLane b) { return {a.v > b.v}; }
+static inline OneLaneMask operator>=(OneLane a, OneLane b) {
+  return {a.v >= b.v};
+}
+static inline OneLaneMask operator&(OneLaneMask a, OneLaneMask b) {
+  return {a.v && b.v};
+}
+static inline OneLaneMask operator|(OneLaneMask a, OneLaneMask b) {
+  return {a.v || b.v};
+}
+static inline OneLaneMask operator~(OneLaneMask a) { return {!a.v}; }
+static inline OneLane select(OneLaneMask m, OneLane a, OneLane b) {
+  return m.v ? a : b;
+}
+static inline bool any(OneLaneMask m) { return m.v; }
+static inline bool all(OneLaneMask m) { return m.v; }
+
+template <typename T> RopeSystem<T>::RopeSystem() {
+  count = 0;
+  stride = 0;
+  solver = ROPE_SOLVER_LEGACY;
+  for (int i = 0; i < points; ++i) {
+    if (i == points - 1)
+      masses[i] = config.ball_mass; // Last point is the ball
+    else
+      masses[i] = config.point_mass; // Other points are lighter
+  }
+}
+
+template <typename T> RopeSystem<T>::~RopeSystem() {}
+
+template <typename T>
+void RopeSystem<T>::place(int r, float center_x, float center_y) {
+  for (int i = 0; i < points; ++i) {
+    int k = i * stride + r;
+    x_curr[k] = center_x - (points / 2.0f * config.spacing) +
+                i * config.spacing;
+    y_curr[k] = center_y;
+    x_prev[k] = x_curr[k];
+    y_prev[k] = y_curr[k];
+  }
+}
+
+template <typename T> void RopeSystem<T>::fit_scratch() {
+  target_x.resize(stride, 0.0f);
+  target_y.resize(stride, 0.0f);
+  dragging.resize(stride, 0.0f);
+  path_x.resize(stride * (ROPE_ANCHOR_SUBSTEPS - 1), 0.0f);
+  path_y.resize(stride * (ROPE_ANCHOR_SUBSTEPS - 1), 0.0f);
+  anchor_substeps.resize(stride, 1);
+  brightness.resize(stride, 0);
+}
+
+template <typename T> int RopeSystem<T>::get_count() { return count; }
+
+template <typename T> int RopeSystem<T>::get_capacity() { return stride; }
+
+template <typename T> void RopeSystem<T>::set_capacity(int n) {
+  n = std::max(n, count);
+  n = (n + ROPE_LANES - 1) / ROPE_LANES * ROPE_LANES;
+  if (n == stride)
+    return;
+
+  // re-interleave the existing ropes at the new stride
+  auto restride = [&](FloatArray &a) {
+    FloatArray out(points * n, 0.0f);
+    for (int i = 0; i < points; ++i)
+      for (int r = 0; r < count; ++r)
+        out[i * n + r] = a[i * stride + r];
+    a.swap(out);
+  };
+  restride(x_curr);
+  restride(y_curr);
+  restride(x_prev);
+  restride(y_prev);
+  stride = n;
+
+  // Unused lanes that share a block with a rope are stepped along with it;
+  // give them a resting rope on the floor so they never divide by a
+  // zero-length segment.
+  for (int r = count; r < stride; ++r)
+    place(r, 0.0f, gGS.winH - FLOOR_HEIGHT);
+
+  anchored.resize(stride, 0);
+  end_speed.resize(stride, 0.0f);
+  filtered_speed.resize(stride, 0.0f);
+  fit_scratch();
+}
+
+template <typename T> int RopeSystem<T>::add(float x, float y) {
+  if (count == stride)
+    set_capacity(std::max(stride * 2, ROPE_LANES));
+  int r = count++;
+  place(r, x, y);
+  anchored[r] = 0;
+  end_speed[r] = 0.0f;
+  filtered_speed[r] = 0.0f;
+  dragging[r] = 0.0f;
+  brightness[r] = 0;
+  return r;
+}
+
+template <typename T>
+void RopeSystem<T>::set_target(int r, SDL_FPoint target, bool drag) {
+  fit_scratch();
+  target_x[r] = target.x;
+  target_y[r] = target.y;
+  dragging[r] = drag ? 1.0f : 0.0f;
+  anchor_substeps[r] = 1;
+}
+
+template <typename T>
+void RopeSystem<T>::set_target_path(int r, const AnchorPath &path, bool drag) {
+  int n = std::clamp(path.count, 1, ROPE_ANCHOR_SUBSTEPS);
+  set_target(r, path.points[n - 1], drag);
+  for (int k = 0; k < n - 1; ++k) {
+    path_x[k * stride + r] = path.points[k].x;
+    path_y[k * stride + r] = path.points[k].y;
+  }
+  anchor_substeps[r] = (Uint8)n;
+}
+
+template <typename T> RopePoints RopeSystem<T>::get_points(int r) {
+  return {x_curr.data() + r, y_curr.data() + r, points, stride};
+}
+
+template <typename T> SDL_FPoint RopeSystem<T>::get_end(int r) {
+  int k = (points - 1) * stride + r;
+  return {x_curr[k], y_curr[k]};
+}
+
+template <typename T> SDL_FPoint RopeSystem<T>::get_anchor(int r) {
+  return {x_curr[r], y_curr[r]};
+}
+
+template <typename T> float RopeSystem<T>::get_speed(int r) {
+  float raw = end_speed[r];
+
+  float alpha = 0.1f; // smoothing factor, 0.05–0.3 works well
+  filtered_speed[r] = filtered_speed[r] + alpha * (raw - filtered_speed[r]);
+
+  return (filtered_speed[r] > 0.4f ? filtered_speed[r] : 0.0f);
+}
+
+template <typename T> void RopeSystem<T>::set_solver(RopeSolver solver) {
+  this->solver = solver;
+}
+
+template <typename T> RopeSolver RopeSystem<T>::get_solver() { return solver; }
+
+// First point follows the target. Per rope rather than per lane: it's one
+// point each, and the blend is done in double like it always was.
+template <typename T> void RopeSystem<T>::follow_targets(int k) {
+  for (int r = 0; r < count; ++r) {
+    if (dragging[r] == 0.0f) {
+      anchored[r] = 0;
+      continue;
+    }
+    if (k >= anchor_substeps[r])
+      continue;
+    bool last = k == anchor_substeps[r] - 1;
+    SDL_FPoint target = last ? SDL_FPoint{target_x[r], target_y[r]}
+                             : SDL_FPoint{path_x[k * stride + r],
+                                          path_y[k * stride + r]};
+    if (!anchored[r]) {
+      if (!last)
+        continue;
+      x_curr[r] += 0.2 * (target.x - x_curr[r]);
+      y_curr[r] += 0.2 * (target.y - y_curr[r]);
+      if (point_distance({x_curr[r], y_curr[r]}, target) < 4.0f)
+        anchored[r] = 1;
+    } else {
+      x_curr[r] = target.x;
+      y_curr[r] = target.y;
+      x_prev[r] = x_curr[r];
+      y_prev[r] = y_curr[r];
+    }
+  }
+}
+
+template <typename T> void RopeSystem<T>::solve_physics() {
+  fit_scratch();
+  int grouped = count - count % ROPE_LANES;
+  for (int b = 0; b < grouped; b += ROPE_LANES)
+    physics_block<Lanes>(b);
+  for (int r = grouped; r < count; ++r)
+    physics_block<OneLane>(r);
+}
+
+template <typename T>
+template <typename L>
+void RopeSystem<T>::physics_block(int b) {
+  using Mask = LaneMaskOf<L>;
+  const float ff = FLOOR_FRICTION;
+  const L floor_y = lanes_set<L>(gGS.winH - FLOOR_HEIGHT);
+  const L zero = lanes_set<L>(0.0f);
+  const L dt2 = lanes_set<L>(DT * DT);
+  const L damping = lanes_set<L>(config.damping);
+
+  Mask drag = lanes_load<L>(&dragging[b]) > zero;
+  L neg_drag = select(drag, lanes_set<L>(-(config.air_resistance * 0.8f)),
+                          lanes_set<L>(-config.air_resistance));
+
+  for (int i = 0; i < points; ++i) {
+    float *xc = &x_curr[i * stride + b];
+    float *yc = &y_curr[i * stride + b];
+    float *xp = &x_prev[i * stride + b];
+    float *yp = &y_prev[i * stride + b];
+    L x = lanes_load<L>(xc), y = lanes_load<L>(yc);
+    L mass = lanes_set<L>(masses[i]);
+
+    L fx = lanes_set<L>(masses[i] * 0.0f);
+    L fy = lanes_set<L>(masses[i] * GRAVITY);
+
+    // --- air drag ---
+    L vx = x - lanes_load<L>(xp);
+    L vy = y - lanes_load<L>(yp);
+    L v_mag = lanes_sqrt(vx * vx + vy * vy);
+    if (i == points - 1)
+      lanes_store(&end_speed[b], v_mag);
+
+    Mask moving = v_mag > lanes_set<L>(1e-4f);
+    L drag_mag = neg_drag * v_mag;
+    fx = select(moving, fx + drag_mag * (vx / v_mag), fx);
+    fy = select(moving, fy + drag_mag * (vy / v_mag), fy);
+
+    // --- floor friction (horizontal only), opposing the motion ---
+    Mask sliding =
+        (y >= floor_y) & (lanes_abs(vx) > lanes_set<L>(1e-5f));
+    L sign = select(vx > zero, lanes_set<L>(1.0f), lanes_set<L>(-1.0f));
+    fx = select(sliding, fx + lanes_set<L>(-ff * masses[i]) * sign, fx);
+
+    // --- integrate ---
+    vx = vx * damping;
+    vy = vy * damping;
+    L x_new = x + vx + dt2 * (fx / mass);
+    L y_new = y + vy + dt2 * (fy / mass);
+    y_new = select(y_new >= floor_y, y_new - (y_new - floor_y), y_new);
+
+    // the dragged anchor is moved by follow_targets only
+    Mask keep = i == 0 ? drag : Mask{};
+    lanes_store(xp, select(keep, lanes_load<L>(xp), x));
+    lanes_store(yp, select(keep, lanes_load<L>(yp), y));
+    lanes_store(xc, select(keep, x, x_new));
+    lanes_store(yc, select(keep, y, y_new));
+  }
+}
+
+// Gauss-Seidel sweeps: forward for dragging ropes with the anchor pinned,
+// backward for the rest with the ball nearly pinned. A block only runs the
+// directions some of its ropes need, and each rope keeps the result of its
+// own direction.
+template <typename T>
+template <typename L>
+void RopeSystem<T>::legacy_block(int b) {
+  using Mask = LaneMaskOf<L>;
+  L x[points], y[points];
+  for (int i = 0; i < points; ++i) {
+    x[i] = lanes_load<L>(&x_curr[i * stride + b]);
+    y[i] = lanes_load<L>(&y_curr[i * stride + b]);
+  }
+  Mask fwd = lanes_load<L>(&dragging[b]) > lanes_set<L>(0.0f);
+  Mask bwd = ~fwd;
+  bool any_fwd = any(fwd), any_bwd = any(bwd);
+  const L spacing = lanes_set<L>(config.spacing);
+  const L half = lanes_set<L>(0.5f);
+  const L ball_move_fraction = lanes_set<L>(0.005f);
+
+  for (int iter = 0; iter < config.iterations; ++iter) {
+    if (any_fwd) {
+      for (int i = 0; i < segments; ++i) {
+        L dx = x[i + 1] - x[i];
+        L dy = y[i + 1] - y[i];
+        L dist = lanes_sqrt(dx * dx + dy * dy);
+        L diff = (dist - spacing) / dist;
+        L off_x = dx * half * diff;
+        L off_y = dy * half * diff;
+
+        // Don't move the dragged point
+        if (i != 0) {
+          x[i] = select(fwd, x[i] + off_x, x[i]);
+          y[i] = select(fwd, y[i] + off_y, y[i]);
+        }
+        x[i + 1] = select(fwd, x[i + 1] - off_x, x[i + 1]);
+        y[i + 1] = select(fwd, y[i + 1] - off_y, y[i + 1]);
+      }
+    }
+    if (any_bwd) {
+      for (int i = points - 2; i >= 0; --i) {
+        L dx = x[i + 1] - x[i];
+        L dy = y[i + 1] - y[i];
+        L dist = lanes_sqrt(dx * dx + dy * dy);
+        L diff = (dist - spacing) / dist;
+        L off_x = dx * half * diff;
+        L off_y = dy * half * diff;
+
+        // Don't move the fixed end ball
+        L x1 = x[i], y1 = y[i];
+        if (i + 1 == points - 1) {
+          x1 = x1 - off_x * ball_move_fraction;
+          y1 = y1 - off_y * ball_move_fraction;
+        } else {
+          x[i + 1] = select(bwd, x[i + 1] - off_x, x[i + 1]);
+          y[i + 1] = select(bwd, y[i + 1] - off_y, y[i + 1]);
+        }
+        x[i] = select(bwd, x1 + off_x, x[i]);
+        y[i] = select(bwd, y1 + off_y, y[i]);
+      }
+    }
+  }
+
+  for (int i = 0; i < points; ++i) {
+    lanes_store(&x_curr[i * stride + b], x[i]);
+    lanes_store(&y_curr[i * stride + b], y[i]);
+  }
+}
+
+// The dragged anchor is pinned, like in the legacy passes.
+template <typename L, size_t N>
+static void inverse_masses(const array<float, N> &masses, LaneMaskOf<L> drag,
+                           L (&inv_mass)[N]) {
+  for (size_t i = 0; i < N; ++i)
+    inv_mass[i] = lanes_set<L>(1.0f / masses[i]);
+  inv_mass[0] = select(drag, lanes_set<L>(0.0f), inv_mass[0]);
+}
+
+// Long range attachments: no point may be further from the root than the
+// rope between them allows. The root is the pinned anchor while dragging and
+// the ball otherwise, and only the other point moves. This carries the
+// heavy end's pull across the whole chain in one pass, which local
+// mass-weighted sweeps can't do with a 20000:1 mass ratio.
+template <typename L, size_t N>
+static void tether(L (&x)[N], L (&y)[N], LaneMaskOf<L> drag, float spacing) {
+  L rx = select(drag, x[0], x[N - 1]);
+  L ry = select(drag, y[0], y[N - 1]);
+  for (int i = 0; i < (int)N; ++i) {
+    L dx = x[i] - rx;
+    L dy = y[i] - ry;
+    L dist = lanes_sqrt(dx * dx + dy * dy);
+    L max_dist = select(drag, lanes_set<L>(std::abs(i) * spacing),
+                            lanes_set<L>(std::abs(i - ((int)N - 1)) * spacing));
+    LaneMaskOf<L> stretched =
+        (dist > max_dist) & (dist > lanes_set<L>(1e-6f));
+    L scale = max_dist / dist;
+    x[i] = select(stretched, rx + dx * scale, x[i]);
+    y[i] = select(stretched, ry + dy * scale, y[i]);
+  }
+}
+
+template <typename L, size_t N>
+static L constraint_error(const L (&x)[N], const L (&y)[N], float spacing) {
+  L err = lanes_set<L>(0.0f);
+  for (int j = 0; j < (int)N - 1; ++j) {
+    L dx = x[j + 1] - x[j];
+    L dy = y[j + 1] - y[j];
+    L c = lanes_sqrt(dx * dx + dy * dy) - lanes_set<L>(spacing);
+    err = err + c * c;
+  }
+  return err;
+}
+
+template <typename T>
+template <typename L>
+void RopeSystem<T>::xpbd_block(int b) {
+  using Mask = LaneMaskOf<L>;
+  L x[points], y[points], inv_mass[points], lambda[segments];
+  for (int i = 0; i < points; ++i) {
+    x[i] = lanes_load<L>(&x_curr[i * stride + b]);
+    y[i] = lanes_load<L>(&y_curr[i * stride + b]);
+  }
+  Mask drag = lanes_load<L>(&dragging[b]) > lanes_set<L>(0.0f);
+  inverse_masses(masses, drag, inv_mass);
+  tether(x, y, drag, config.spacing);
+  const L alpha = lanes_set<L>(config.compliance / (DT * DT));
+  const L spacing = lanes_set<L>(config.spacing);
+  for (int j = 0; j < segments; ++j)
+    lambda[j] = lanes_set<L>(0.0f);
+
+  for (int iter = 0; iter < ROPE_XPBD_ITERATIONS; ++iter) {
+    for (int j = 0; j < segments; ++j) {
+      L w1 = inv_mass[j];
+      L w2 = inv_mass[j + 1];
+      L dx = x[j + 1] - x[j];
+      L dy = y[j + 1] - y[j];
+      L dist = lanes_sqrt(dx * dx + dy * dy);
+      Mask ok = ~(dist < lanes_set<L>(1e-6f));
+
+      L c = dist - spacing;
+      L dl = (-c - alpha * lambda[j]) / (w1 + w2 + alpha);
+      lambda[j] = select(ok, lambda[j] + dl, lambda[j]);
+
+      L nx = dx / dist;
+      L ny = dy / dist;
+      x[j] = select(ok, x[j] - w1 * dl * nx, x[j]);
+      y[j] = select(ok, y[j] - w1 * dl * ny, y[j]);
+      x[j + 1] = select(ok, x[j + 1] + w2 * dl * nx, x[j + 1]);
+      y[j + 1] = select(ok, y[j + 1] + w2 * dl * ny, y[j + 1]);
+    }
+  }
+
+  for (int i = 0; i < points; ++i) {
+    lanes_store(&x_curr[i * stride + b], x[i]);
+    lanes_store(&y_curr[i * stride + b], y[i]);
+  }
+}
+
+// Segment j's constraint is C_j = |p[j+1] - p[j]| - config.spacing with
+// gradient -n_j at p[j] and n_j at p[j+1]. Segments only share a point with
+// their neighbours, so J W J^T (W = inverse masses) is tridiagonal:
+//   diagonal        w[j] + w[j+1] (+ compliance)
+//   between j, j+1  -w[j+1] * dot(n_j, n_{j+1})
+// Each Newton step solves it exactly with the Thomas algorithm, so the
+// correction reaches the whole chain at once however long it is, and then
+// moves point i by w[i] * (n_{i-1} dl_{i-1} - n_i dl_i).
+template <typename T>
+template <typename L>
+void RopeSystem<T>::direct_block(int b) {
+  using Mask = LaneMaskOf<L>;
+  const int m = segments;
+  L x[points], y[points], inv_mass[points];
+  L step_x[points], step_y[points], base_x[points], base_y[points];
+  L lambda[segments], seg_nx[segments], seg_ny[segments];
+  L diag[segments], off[segments], rhs[segments], delta[segments];
+  for (int i = 0; i < points; ++i) {
+    x[i] = lanes_load<L>(&x_curr[i * stride + b]);
+    y[i] = lanes_load<L>(&y_curr[i * stride + b]);
+  }
+  Mask drag = lanes_load<L>(&dragging[b]) > lanes_set<L>(0.0f);
+  inverse_masses(masses, drag, inv_mass);
+  tether(x, y, drag, config.spacing);
+  const L alpha = lanes_set<L>(config.compliance / (DT * DT));
+  const L spacing = lanes_set<L>(config.spacing);
+  const L min_dist = lanes_set<L>(1e-6f);
+  for (int j = 0; j < m; ++j)
+    lambda[j] = lanes_set<L>(0.0f);
+
+  for (int iter = 0; iter < ROPE_DIRECT_ITERATIONS; ++iter) {
+    for (int j = 0; j < m; ++j) {
+      L dx = x[j + 1] - x[j];
+      L dy = y[j + 1] - y[j];
+      L dist = lanes_sqrt(dx * dx + dy * dy);
+      dist = select(dist < min_dist, min_dist, dist);
+      seg_nx[j] = dx / dist;
+      seg_ny[j] = dy / dist;
+      rhs[j] = -(dist - spacing) - alpha * lambda[j];
+      diag[j] = inv_mass[j] + inv_mass[j + 1] + alpha;
+    }
+    for (int j = 0; j < m - 1; ++j)
+      off[j] = -inv_mass[j + 1] *
+               (seg_nx[j] * seg_nx[j + 1] + seg_ny[j] * seg_ny[j + 1]);
+
+    // Thomas algorithm: eliminate the sub-diagonal, then back-substitute
+    for (int j = 1; j < m; ++j) {
+      L k = off[j - 1] / diag[j - 1];
+      diag[j] = diag[j] - k * off[j - 1];
+      rhs[j] = rhs[j] - k * rhs[j - 1];
+    }
+    delta[m - 1] = rhs[m - 1] / diag[m - 1];
+    for (int j = m - 2; j >= 0; --j)
+      delta[j] = (rhs[j] - off[j] * delta[j + 1]) / diag[j];
+
+    for (int i = 0; i < points; ++i) {
+      L px = lanes_set<L>(0.0f), py = lanes_set<L>(0.0f);
+      if (i > 0) {
+        px = px + seg_nx[i - 1] * delta[i - 1];
+        py = py + seg_ny[i - 1] * delta[i - 1];
+      }
+      if (i < m) {
+        px = px - seg_nx[i] * delta[i];
+        py = py - seg_ny[i] * delta[i];
+      }
+      step_x[i] = inv_mass[i] * px;
+      step_y[i] = inv_mass[i] * py;
+    }
+
+    // The linearisation is poor for nearly taut zigzags, where light points
+    // swing a long way sideways; halve the step until it helps. Each rope
+    // stops halving at its own first improvement.
+    L err = constraint_error(x, y, config.spacing);
+    for (int i = 0; i < points; ++i) {
+      base_x[i] = x[i];
+      base_y[i] = y[i];
+    }
+    L scale = lanes_set<L>(1.0f);
+    Mask done = lanes_set<L>(0.0f) > lanes_set<L>(0.0f);
+    for (int tries = 0; tries < ROPE_DIRECT_BACKTRACKS; ++tries) {
+      if (tries > 0)
+        scale = select(done, scale, scale * lanes_set<L>(0.5f));
+      for (int i = 0; i < points; ++i) {
+        x[i] = select(done, x[i], base_x[i] + scale * step_x[i]);
+        y[i] = select(done, y[i], base_y[i] + scale * step_y[i]);
+      }
+      done = done | (constraint_error(x, y, config.spacing) < err);
+      if (all(done))
+        break;
+    }
+    // A rope no try improved stays where it started, and its multipliers
+    // take none of the step; the rest take the scale they were moved by.
+    for (int i = 0; i < points; ++i) {
+      x[i] = select(done, x[i], base_x[i]);
+      y[i] = select(done, y[i], base_y[i]);
+    }
+    scale = select(done, scale, lanes_set<L>(0.0f));
+    for (int j = 0; j < m; ++j)
+      lambda[j] = lambda[j] + scale * delta[j];
+  }
+
+  for (int i = 0; i < points; ++i) {
+    lanes_store(&x_curr[i * stride + b], x[i]);
+    lanes_store(&y_curr[i * stride + b], y[i]);
+  }
+}
+
+template <typename T>
+template <typename L>
+void RopeSystem<T>::constraints_block(int b) {
+  if (solver == ROPE_SOLVER_XPBD)
+    xpbd_block<L>(b);
+  else if (solver == ROPE_SOLVER_DIRECT)
+    direct_block<L>(b);
+  else
+    legacy_block<L>(b);
+}
+
+template <typename T> void RopeSystem<T>::solve_constraints() {
+  fit_scratch();
+  int grouped = count - count % ROPE_LANES;
+  for (int b = 0; b < grouped; b += ROPE_LANES)
+    constraints_block<Lanes>(b);
+  for (int r = grouped; r < count; ++r)
+    constraints_block<OneLane>(r);
+}
+
+template <typename T> void RopeSystem<T>::update() {
+  fit_scratch();
+
+  // Apply forces. The dragged anchors are left alone, so this can go
+  // before they move.
+  solve_physics();
+
+  // Walk the anchors along their paths, enforcing the constraints at each
+  // point so the rope is pulled along the whole motion. With no path this
+  // is one follow and one solve, as it always was.
+  int substeps = 1;
+  for (int r = 0; r < count; ++r)
+    substeps = std::max(substeps, (int)anchor_substeps[r]);
+  for (int k = 0; k < substeps; ++k) {
+    follow_targets(k);
+    solve_constraints();
+  }
+  std::fill(anchor_substeps.begin(), anchor_substeps.end(), 1);
+
+  update_brightness();
+}
+
+// Ropes fade to white as their ball climbs into space. Worked out per step
+// rather than per draw so a captured RopeDrawList carries them.
+template <typename T> void RopeSystem<T>::update_brightness() {
+  float space_y = -(10000.0 - gGS.winH);
+  float transition_y = space_y + 800.0f;
+  for (int r = 0; r < count; ++r) {
+    float ropeY = get_end(r).y;
+    if (ropeY <= transition_y) {
+
+      float clamped = std::max(ropeY, space_y);
+
+      // Map linearly from 800 → 950 to 0 → 255
+      brightness[r] =
+          (int)((transition_y - clamped) / (transition_y - space_y) * 255.0f);
+    }
+  }
+}
+
+template <typename T> void RopeSystem<T>::capture(RopeDrawList &out) {
+  fit_scratch();
+  int n = points * stride;
+  out.count = count;
+  out.points = points;
+  out.stride = stride;
+  out.x_prev.assign(x_prev.data(), x_prev.data() + n);
+  out.y_prev.assign(y_prev.data(), y_prev.data() + n);
+  out.x_curr.assign(x_curr.data(), x_curr.data() + n);
+  out.y_curr.assign(y_curr.data(), y_curr.data() + n);
+  out.brightness.assign(brightness.begin(), brightness.begin() + count);
+}
+
+template <typename T>
+void RopeSystem<T>::draw(SDL_Renderer *renderer, Camera &camera,
+                         float alpha) {
+  capture(draw_list);
+  draw_list.draw(renderer, camera, alpha);
+}
+
+RopeDrawList::RopeDrawList() : count(0), points(0), stride(0) {}
+
+int RopeDrawList::get_count() { return count; }
+
+void RopeDrawList::draw(SDL_Renderer *renderer, Camera &camera, float alpha) {
+  if (count == 0)
+    return;
+
+  // blend and transform every lane at once; unused lanes are simply not
+  // read
+  int n = points * stride;
+  int segments = points - 1;
+  draw_x.resize(n);
+  draw_y.resize(n);
+  for (int k = 0; k < n; ++k) {
+    draw_x[k] = x_prev[k] + (x_curr[k] - x_prev[k]) * alpha;
+    draw_y[k] = y_prev[k] + (y_curr[k] - y_prev[k]) * alpha;
+  }
+  screen_points.resize(n);
+  camera.world_to_screen(draw_x.data(), draw_y.data(), screen_points.data(),
+                         n);
+
+  vertices.clear();
+  indices.clear();
+  SDL_FColor color = {};
+  for (int r = 0; r < count; ++r) {
+    float c = brightness[r] / 255.0f;
+    color = {c, c, c, 1.0f};
+
+    // each segment is a ROPE_LINE_WIDTH wide quad
+    for (int i = 0; i < segments; ++i) {
+      SDL_FPoint a = screen_points[i * stride + r];
+      SDL_FPoint e = screen_points[(i + 1) * stride + r];
+      SDL_FPoint d = {e.x - a.x, e.y - a.y};
+      float len = sqrtf(d.x * d.x + d.y * d.y);
+      float h = len > 1e-6f ? ROPE_LINE_WIDTH * 0.5f / len : 0.0f;
+      SDL_FPoint n = {-d.y * h, d.x * h};
+
+      int base = (int)vertices.size();
+      vertices.push_back({{a.x + n.x, a.y + n.y}, color, {0.0f, 0.0f}});
+      vertices.push_back({{a.x - n.x, a.y - n.y}, color, {0.0f, 0.0f}});
+      vertices.push_back({{e.x + n.x, e.y + n.y}, color, {0.0f, 0.0f}});
+      vertices.push_back({{e.x - n.x, e.y - n.y}, color, {0.0f, 0.0f}});
+      int quad[] = {base, base + 1, base + 2, base + 1, base + 3, base + 2};
+      indices.insert(indices.end(), quad, quad + 6);
+    }
+
+    SDL_FPoint ball = screen_points[(points - 1) * stride + r];
+    circle_batch.add(static_cast<int>(ball.x), static_cast<int>(ball.y),
+                     static_cast<int>(BALL_RADIUS), color);
+  }
+
+  SDL_RenderGeometry(renderer, nullptr, vertices.data(), (int)vertices.size(),
+                     indices.data(), (int)indices.size());
+  circle_batch.draw(renderer);
+  SDL_SetRenderDrawColor(renderer, brightness[count - 1],
+                         brightness[count - 1], brightness[count - 1], 255);
+}
+
+// the registered rope types; see rope_registry.h
+template class RopeSystem<DefaultRope>;
+template class RopeSystem<ShortStiffRope>;
+template class RopeSystem<LongWhippyRope>;
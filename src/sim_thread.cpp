@@ -0,0 +1,115 @@
+#include "sim_thread.h"
+#include "globals.h"
+#include "profiler.h"
+#include "utils.h"
+
+#include <algorithm>
+
+SimThread::SimThread(Simulation &sim, InputReplay *replay,
+                     InputRecorder *recorder, StateHashLog *hash_log)
+    : sim(sim), replay(replay), recorder(recorder), hash_log(hash_log),
+      clock(DT), frame(0), dragging(false), input_time(0), quit(false),
+      done(false), have_snapshot(false) {
+  // something to draw before the first step
+  publish();
+}
+
+SimThread::~SimThread() { stop(); }
+
+void SimThread::start() {
+  quit = false;
+  worker = thread(&SimThread::worker_main, this);
+}
+
+void SimThread::stop() {
+  quit = true;
+  if (worker.joinable())
+    worker.join();
+}
+
+void SimThread::worker_main() {
+  while (!quit && !done) {
+    tick();
+    clock.wait_step();
+  }
+}
+
+void SimThread::tick() {
+  int steps = clock.advance();
+  if (steps == 0)
+    return;
+
+  lock_guard<mutex> lk(lock);
+  Camera &camera = sim.get_camera();
+  Uint64 last_due = clock.get_step_time();
+  for (int s = 0; s < steps; ++s) {
+    gGS.isDragging = dragging.load(memory_order_relaxed);
+
+    // steps caught up on only see the input up to when they fell due; the
+    // last one takes everything, for the least latency
+    Uint64 until = s == steps - 1
+                       ? ~0ull
+                       : last_due - (steps - 1 - s) * clock.get_step_ns();
+    SDL_FPoint mouseScreen[ROPE_ANCHOR_SUBSTEPS];
+    int taken = mouse.take_path(until, mouseScreen, ROPE_ANCHOR_SUBSTEPS,
+                                input_time);
+    AnchorPath mouseWorld = {};
+    mouseWorld.count = gGS.isDragging ? taken : 1;
+    for (int k = 0; k < mouseWorld.count; ++k)
+      mouseWorld.points[k] =
+          camera.screenToWorld(mouseScreen[taken - mouseWorld.count + k]);
+
+    if (replay) {
+      if (replay->done()) {
+        done = true;
+        break;
+      }
+      const FrameInput &input = replay->next();
+      apply_frame_input(input);
+      mouseWorld = input.mouseWorld;
+    }
+    if (recorder)
+      recorder->write(capture_frame_input(mouseWorld));
+
+    sim.step(mouseWorld);
+    if (hash_log)
+      hash_log->write(frame++, sim);
+  }
+  publish();
+}
+
+void SimThread::publish() {
+  PROFILE_ZONE("sim.publish");
+  RenderSnapshot &out = snapshots.write_slot();
+  out.step_time = clock.get_step_time();
+  out.input_time = input_time;
+  out.camera = sim.get_camera();
+  sim.visit_rope([&](auto &rope) { rope.capture(out.rope); });
+  sim.get_enemy_system().capture(out.camera, out.enemies);
+  out.altitude = gGS.altitude;
+  out.speed = gGS.speed;
+  snapshots.publish();
+}
+
+MouseSampler &SimThread::get_mouse() { return mouse; }
+
+void SimThread::set_dragging(bool dragging) {
+  this->dragging.store(dragging, memory_order_relaxed);
+}
+
+unique_lock<mutex> SimThread::pause() { return unique_lock<mutex>(lock); }
+
+RenderSnapshot *SimThread::latest() {
+  have_snapshot |= snapshots.acquire();
+  return have_snapshot ? &snapshots.read() : nullptr;
+}
+
+float SimThread::get_alpha(const RenderSnapshot &snapshot) {
+  Uint64 now = SDL_GetTicksNS();
+  if (now <= snapshot.step_time)
+    return 0.0f;
+  return std::min((float)(now - snapshot.step_time) / clock.get_step_ns(),
+                  1.0f);
+}
+
+bool SimThread::finished() { return done; }
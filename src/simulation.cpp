@@ -0,0 +1,44 @@
+#include "simulation.h"
+#include "globals.h"
+#include "profiler.h"
+
+Simulation::Simulation(Uint64 seed) : rng_state(seed) {}
+
+Simulation::~Simulation() {}
+
+void Simulation::set_rope_type(int type) { make_rope(rope, type); }
+
+int Simulation::get_rope_type() { return (int)rope.index(); }
+
+Camera &Simulation::get_camera() { return camera; }
+
+EnemySystem &Simulation::get_enemy_system() { return enemy_system; }
+
+void Simulation::step(SDL_FPoint mouseWorld) {
+  AnchorPath mouse = {};
+  mouse.points[0] = mouseWorld;
+  mouse.count = 1;
+  step(mouse);
+}
+
+void Simulation::step(const AnchorPath &mouse) {
+  std::visit(
+      [&](auto &rope) {
+        {
+          PROFILE_ZONE("rope.update");
+          rope.update(mouse);
+        }
+        {
+          PROFILE_ZONE("camera.update");
+          camera.update(rope.get_anchor(), rope.get_end());
+        }
+        {
+          PROFILE_ZONE("enemy_system.update");
+          enemy_system.update(camera, rng_state, rope.get_points());
+        }
+
+        gGS.altitude = rope.get_altitude();
+        gGS.speed = rope.get_speed();
+      },
+      rope);
+}
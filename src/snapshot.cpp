@@ -0,0 +1,201 @@
+#include "snapshot.h"
+#include "globals.h"
+#include "mapped_file.h"
+#include "state_fields.h"
+#include "utils.h"
+
+#include <cstring>
+#include <vector>
+
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+template <typename F> static void for_each_snapshot_field(Simulation &sim, F &&f) {
+  f("gGS.winW", gGS.winW);
+  f("gGS.winH", gGS.winH);
+  f("gGS.isDragging", gGS.isDragging);
+  sim.for_each_field(f);
+}
+
+// Fields are checked one at a time against this build; these check the ones
+// that size each other, so a stale or crafted file can't leave count past
+// the end of its arrays. Read straight from the file, before sim is touched.
+static bool check_field_sizes(const char *path, const MappedFile &file,
+                              const vector<SnapshotField> &fields,
+                              int rope_points) {
+  auto find = [&](const char *name) -> const SnapshotField * {
+    for (const SnapshotField &f : fields)
+      if (strncmp(f.name, name, SNAPSHOT_NAME_LEN) == 0)
+        return &f;
+    return nullptr;
+  };
+  auto read_int = [&](const char *name, int &value) {
+    const SnapshotField *f = find(name);
+    if (!f || f->bytes != sizeof(int))
+      return false;
+    memcpy(&value, file.bytes() + f->offset, sizeof(int));
+    return true;
+  };
+  auto elems_are = [&](const char *name, Uint64 n) {
+    const SnapshotField *f = find(name);
+    return f && f->bytes / f->elem_size == n;
+  };
+
+  int enemies = 0;
+  bool ok = read_int("enemy.count", enemies) && enemies >= 0;
+  for (const char *name :
+       {"enemy.enemy_type", "enemy.x_curr", "enemy.y_curr", "enemy.x_prev",
+        "enemy.y_prev", "enemy.attraction", "enemy.mass", "enemy.radius",
+        "enemy.max_vel", "enemy.age"})
+    ok = ok && elems_are(name, (Uint64)enemies);
+  if (!ok) {
+    SDL_Log("%s: enemy arrays don't match enemy.count", path);
+    return false;
+  }
+
+  int ropes = 0, stride = 0;
+  ok = read_int("rope.count", ropes) && read_int("rope.stride", stride) &&
+       ropes >= 1 && ropes <= stride && stride % ROPE_LANES == 0;
+  for (const char *name :
+       {"rope.x_curr", "rope.y_curr", "rope.x_prev", "rope.y_prev"})
+    ok = ok && elems_are(name, (Uint64)rope_points * stride);
+  for (const char *name :
+       {"rope.anchored", "rope.end_speed", "rope.filtered_speed"})
+    ok = ok && elems_are(name, (Uint64)stride);
+  if (!ok) {
+    SDL_Log("%s: rope arrays don't match rope.count and rope.stride", path);
+    return false;
+  }
+  return true;
+}
+
+static Uint64 align_up(Uint64 v) {
+  return (v + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+}
+
+bool save_snapshot(const char *path, Simulation &sim) {
+  vector<SnapshotField> fields;
+  vector<const void *> sources;
+
+  for_each_snapshot_field(sim, [&](const char *name, auto &field) {
+    using View = FieldView<std::remove_reference_t<decltype(field)>>;
+    SnapshotField entry = {};
+    SDL_strlcpy(entry.name, name, SNAPSHOT_NAME_LEN);
+    entry.bytes = View::bytes(field);
+    entry.elem_size = (Uint32)View::elem_size();
+    fields.push_back(entry);
+    sources.push_back(View::data(field));
+  });
+
+  Uint64 offset = align_up(sizeof(SnapshotHeader) +
+                           fields.size() * sizeof(SnapshotField));
+  for (SnapshotField &entry : fields) {
+    entry.offset = offset;
+    offset = align_up(offset + entry.bytes);
+  }
+
+  SnapshotHeader header = {SNAPSHOT_MAGIC,      SNAPSHOT_VERSION,
+                           SNAPSHOT_BYTE_ORDER, (Uint32)fields.size(),
+                           (Uint32)sim.get_rope_type(), 0,
+                           offset};
+
+  SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+  if (!io) {
+    SDL_Log("Failed to open %s for snapshot: %s", path, SDL_GetError());
+    return false;
+  }
+
+  static const Uint8 zeros[SNAPSHOT_ALIGN] = {};
+  bool ok = SDL_WriteIO(io, &header, sizeof(header)) == sizeof(header);
+  ok = ok && SDL_WriteIO(io, fields.data(),
+                         fields.size() * sizeof(SnapshotField)) ==
+                 fields.size() * sizeof(SnapshotField);
+  for (size_t i = 0; ok && i < fields.size(); ++i) {
+    Sint64 pad = (Sint64)fields[i].offset - SDL_TellIO(io);
+    ok = SDL_WriteIO(io, zeros, pad) == (size_t)pad &&
+         SDL_WriteIO(io, sources[i], fields[i].bytes) == fields[i].bytes;
+  }
+  Sint64 pad = (Sint64)header.file_size - SDL_TellIO(io);
+  ok = ok && SDL_WriteIO(io, zeros, pad) == (size_t)pad;
+  SDL_CloseIO(io);
+
+  if (!ok) {
+    SDL_Log("Failed to write snapshot %s", path);
+    return false;
+  }
+  SDL_Log("Saved snapshot %s (%llu bytes)", path,
+          (unsigned long long)header.file_size);
+  return true;
+}
+
+bool load_snapshot(const char *path, Simulation &sim) {
+  MappedFile file;
+  if (!file.open(path)) {
+    SDL_Log("Failed to open snapshot %s: %s", path, SDL_GetError());
+    return false;
+  }
+
+  SnapshotHeader header;
+  if (file.get_size() < sizeof(header)) {
+    SDL_Log("%s is too small to be a snapshot", path);
+    return false;
+  }
+  memcpy(&header, file.bytes(), sizeof(header));
+  if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION ||
+      header.byte_order != SNAPSHOT_BYTE_ORDER ||
+      header.file_size != file.get_size() ||
+      sizeof(header) + header.field_count * sizeof(SnapshotField) >
+          file.get_size()) {
+    SDL_Log("%s is not a version %u snapshot for this machine", path,
+            SNAPSHOT_VERSION);
+    return false;
+  }
+
+  if (header.rope_type != (Uint32)sim.get_rope_type()) {
+    SDL_Log("%s holds a '%s' rope; run with --rope %s to load it", path,
+            rope_type_name((int)header.rope_type),
+            rope_type_name((int)header.rope_type));
+    return false;
+  }
+
+  vector<SnapshotField> fields(header.field_count);
+  memcpy(fields.data(), file.bytes() + sizeof(header),
+         header.field_count * sizeof(SnapshotField));
+
+  // validate the whole table first so a bad file leaves sim untouched
+  size_t index = 0;
+  bool valid = true;
+  for_each_snapshot_field(sim, [&](const char *name, auto &field) {
+    using View = FieldView<std::remove_reference_t<decltype(field)>>;
+    if (!valid)
+      return;
+    if (index >= fields.size() ||
+        strncmp(fields[index].name, name, SNAPSHOT_NAME_LEN) != 0 ||
+        fields[index].elem_size != View::elem_size() ||
+        fields[index].bytes % View::elem_size() != 0 ||
+        (!View::resizable && fields[index].bytes != View::elem_size()) ||
+        fields[index].offset + fields[index].bytes > file.get_size()) {
+      SDL_Log("%s: field %s doesn't match this build", path, name);
+      valid = false;
+    }
+    index++;
+  });
+  if (!valid || index != fields.size())
+    return false;
+  int rope_points = sim.visit_rope([](auto &rope) { return rope.points; });
+  if (!check_field_sizes(path, file, fields, rope_points))
+    return false;
+
+  index = 0;
+  for_each_snapshot_field(sim, [&](const char *, auto &field) {
+    using View = FieldView<std::remove_reference_t<decltype(field)>>;
+    const SnapshotField &entry = fields[index++];
+    View::resize(field, entry.bytes / View::elem_size());
+    memcpy(View::data(field), file.bytes() + entry.offset, entry.bytes);
+  });
+  sim.get_enemy_system().resync();
+  // there's no previous frame to blend from after a jump
+  sim.get_camera().settle();
+
+  SDL_Log("Loaded snapshot %s", path);
+  return true;
+}
@@ -0,0 +1,186 @@
+#include "state_hash.h"
+#include "state_fields.h"
+
+#include <cstring>
+
+#define HASH_SEED 0x9e3779b97f4a7c15ull
+#define HASH_MUL 0xff51afd7ed558ccdull
+
+static Uint64 mix(Uint64 h) {
+  h ^= h >> 33;
+  h *= HASH_MUL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+Uint64 hash_bytes(const void *data, size_t bytes) {
+  const Uint8 *p = (const Uint8 *)data;
+  Uint64 h = HASH_SEED ^ (bytes * HASH_MUL);
+
+  size_t words = bytes / 8;
+  for (size_t i = 0; i < words; ++i) {
+    Uint64 w;
+    memcpy(&w, p + i * 8, 8);
+    h = (h ^ w) * HASH_MUL;
+    h = (h << 31) | (h >> 33);
+  }
+
+  Uint64 tail = 0;
+  memcpy(&tail, p + words * 8, bytes - words * 8);
+  h ^= tail;
+
+  return mix(h);
+}
+
+void hash_state(Simulation &sim, vector<Uint64> &out) {
+  out.clear();
+  sim.for_each_field([&](const char *, auto &field) {
+    using View = FieldView<std::remove_reference_t<decltype(field)>>;
+    out.push_back(hash_bytes(View::data(field), View::bytes(field)));
+  });
+}
+
+StateHashLog::StateHashLog() { io = nullptr; }
+
+StateHashLog::~StateHashLog() { close(); }
+
+bool StateHashLog::open(const char *path, Simulation &sim) {
+  io = SDL_IOFromFile(path, "wb");
+  if (!io) {
+    SDL_Log("Failed to open %s for hash log: %s", path, SDL_GetError());
+    return false;
+  }
+
+  vector<const char *> names;
+  sim.for_each_field([&](const char *name, auto &) { names.push_back(name); });
+
+  SDL_WriteU32LE(io, HASH_LOG_MAGIC);
+  SDL_WriteU32LE(io, HASH_LOG_VERSION);
+  SDL_WriteU32LE(io, (Uint32)names.size());
+  for (const char *name : names) {
+    Uint8 len = (Uint8)strlen(name);
+    SDL_WriteU8(io, len);
+    SDL_WriteIO(io, name, len);
+  }
+  return true;
+}
+
+void StateHashLog::write(int frame, Simulation &sim) {
+  if (!io)
+    return;
+
+  hash_state(sim, hashes);
+  SDL_WriteU32LE(io, (Uint32)frame);
+  for (Uint64 h : hashes)
+    SDL_WriteU64LE(io, h);
+}
+
+void StateHashLog::close() {
+  if (!io)
+    return;
+  SDL_CloseIO(io);
+  io = nullptr;
+}
+
+typedef struct {
+  SDL_IOStream *io;
+  vector<string> fields;
+} HashLogReader;
+
+static bool open_reader(const char *path, HashLogReader &reader) {
+  reader.io = SDL_IOFromFile(path, "rb");
+  if (!reader.io) {
+    SDL_Log("Failed to open hash log %s: %s", path, SDL_GetError());
+    return false;
+  }
+
+  Uint32 magic = 0, version = 0, field_count = 0;
+  if (!SDL_ReadU32LE(reader.io, &magic) ||
+      !SDL_ReadU32LE(reader.io, &version) ||
+      !SDL_ReadU32LE(reader.io, &field_count) || magic != HASH_LOG_MAGIC ||
+      version != HASH_LOG_VERSION) {
+    SDL_Log("%s is not a version %u hash log", path, HASH_LOG_VERSION);
+    return false;
+  }
+
+  for (Uint32 i = 0; i < field_count; ++i) {
+    Uint8 len = 0;
+    char name[256];
+    if (!SDL_ReadU8(reader.io, &len) ||
+        SDL_ReadIO(reader.io, name, len) != len) {
+      SDL_Log("%s: truncated field table", path);
+      return false;
+    }
+    reader.fields.push_back(string(name, len));
+  }
+  return true;
+}
+
+static bool read_frame(HashLogReader &reader, Uint32 &frame,
+                       vector<Uint64> &hashes) {
+  hashes.resize(reader.fields.size());
+  if (!SDL_ReadU32LE(reader.io, &frame))
+    return false;
+  for (Uint64 &h : hashes) {
+    if (!SDL_ReadU64LE(reader.io, &h))
+      return false;
+  }
+  return true;
+}
+
+int compare_hash_logs(const char *path_a, const char *path_b) {
+  HashLogReader a = {nullptr, {}};
+  HashLogReader b = {nullptr, {}};
+  int result = 2;
+
+  if (open_reader(path_a, a) && open_reader(path_b, b)) {
+    if (a.fields != b.fields) {
+      SDL_Log("Hash logs record different fields, can't compare");
+    } else {
+      Uint32 frame_a = 0, frame_b = 0;
+      vector<Uint64> hashes_a, hashes_b;
+      int frames = 0;
+      result = 0;
+
+      while (result == 0) {
+        bool more_a = read_frame(a, frame_a, hashes_a);
+        bool more_b = read_frame(b, frame_b, hashes_b);
+        if (!more_a && !more_b)
+          break;
+        if (more_a != more_b) {
+          // a log that stops early diverges where it stops
+          SDL_Log("First divergence at frame %u: %s ends there, %s goes on",
+                  more_a ? frame_a : frame_b, more_a ? path_b : path_a,
+                  more_a ? path_a : path_b);
+          result = 1;
+          break;
+        }
+        if (frame_a != frame_b) {
+          SDL_Log("Frame numbers out of step: %u vs %u", frame_a, frame_b);
+          result = 1;
+          break;
+        }
+        for (size_t i = 0; i < a.fields.size(); ++i) {
+          if (hashes_a[i] == hashes_b[i])
+            continue;
+          if (result == 0)
+            SDL_Log("First divergence at frame %u:", frame_a);
+          SDL_Log("  %s", a.fields[i].c_str());
+          result = 1;
+        }
+        frames++;
+      }
+
+      if (result == 0)
+        SDL_Log("Hash logs match over %d frames", frames);
+    }
+  }
+
+  if (a.io)
+    SDL_CloseIO(a.io);
+  if (b.io)
+    SDL_CloseIO(b.io);
+  return result;
+}
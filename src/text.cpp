@@ -0,0 +1,151 @@
+#include "text.h"
+
+#include <algorithm>
+
+GlyphAtlas::GlyphAtlas() {
+  texture = nullptr;
+  line_height = 0.0f;
+  for (Glyph &g : glyphs)
+    g = {{0.0f, 0.0f, 0.0f, 0.0f}, 0.0f};
+}
+
+GlyphAtlas::~GlyphAtlas() {
+  if (texture)
+    SDL_DestroyTexture(texture);
+}
+
+bool GlyphAtlas::build(SDL_Renderer *renderer, TTF_Font *font) {
+  if (!font)
+    return false;
+
+  SDL_Color white{255, 255, 255, 255};
+  SDL_Surface *rendered[GLYPH_LAST - GLYPH_FIRST + 1];
+
+  // shelf-pack the glyphs into rows of GLYPH_ATLAS_WIDTH
+  int x = 0, y = 0, row_h = 0;
+  for (int c = GLYPH_FIRST; c <= GLYPH_LAST; ++c) {
+    Glyph &g = glyphs[c - GLYPH_FIRST];
+    int advance = 0;
+    TTF_GetGlyphMetrics(font, c, nullptr, nullptr, nullptr, nullptr, &advance);
+    g.advance = (float)advance;
+
+    SDL_Surface *s = TTF_RenderGlyph_Blended(font, c, white);
+    rendered[c - GLYPH_FIRST] = s;
+    if (!s)
+      continue; // e.g. space: advance only
+
+    if (x + s->w > GLYPH_ATLAS_WIDTH) {
+      x = 0;
+      y += row_h + 1;
+      row_h = 0;
+    }
+    g.src = {(float)x, (float)y, (float)s->w, (float)s->h};
+    x += s->w + 1;
+    row_h = std::max(row_h, s->h);
+  }
+
+  SDL_Surface *atlas =
+      SDL_CreateSurface(GLYPH_ATLAS_WIDTH, y + row_h, SDL_PIXELFORMAT_ARGB8888);
+  for (int c = GLYPH_FIRST; c <= GLYPH_LAST; ++c) {
+    SDL_Surface *s = rendered[c - GLYPH_FIRST];
+    if (!s)
+      continue;
+    if (atlas) {
+      const SDL_FRect &src = glyphs[c - GLYPH_FIRST].src;
+      SDL_Rect dst{(int)src.x, (int)src.y, s->w, s->h};
+      SDL_SetSurfaceBlendMode(s, SDL_BLENDMODE_NONE);
+      SDL_BlitSurface(s, nullptr, atlas, &dst);
+    }
+    SDL_DestroySurface(s);
+  }
+  if (!atlas) {
+    SDL_Log("Failed to create glyph atlas: %s", SDL_GetError());
+    return false;
+  }
+
+  texture = SDL_CreateTextureFromSurface(renderer, atlas);
+  SDL_DestroySurface(atlas);
+  if (!texture) {
+    SDL_Log("Failed to upload glyph atlas: %s", SDL_GetError());
+    return false;
+  }
+  SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+  line_height = (float)TTF_GetFontHeight(font);
+  return true;
+}
+
+bool GlyphAtlas::ready() { return texture != nullptr; }
+
+const Glyph &GlyphAtlas::get(char c) {
+  if (c < GLYPH_FIRST || c > GLYPH_LAST)
+    c = '?';
+  return glyphs[c - GLYPH_FIRST];
+}
+
+SDL_Texture *GlyphAtlas::get_texture() { return texture; }
+
+float GlyphAtlas::get_line_height() { return line_height; }
+
+TextLabel::TextLabel() { width = 0.0f; }
+
+TextLabel::~TextLabel() {}
+
+void TextLabel::set_text(GlyphAtlas &atlas, const string &new_text) {
+  if (new_text == text)
+    return;
+  text = new_text;
+  vertices.clear();
+
+  SDL_Texture *tex = atlas.get_texture();
+  float inv_w = 1.0f / tex->w;
+  float inv_h = 1.0f / tex->h;
+  SDL_FColor white{1.0f, 1.0f, 1.0f, 1.0f};
+
+  float pen = 0.0f;
+  for (char c : text) {
+    const Glyph &g = atlas.get(c);
+    if (g.src.w > 0.0f) {
+      float u0 = g.src.x * inv_w, u1 = (g.src.x + g.src.w) * inv_w;
+      float v0 = g.src.y * inv_h, v1 = (g.src.y + g.src.h) * inv_h;
+      vertices.push_back({{pen, 0.0f}, white, {u0, v0}});
+      vertices.push_back({{pen + g.src.w, 0.0f}, white, {u1, v0}});
+      vertices.push_back({{pen + g.src.w, g.src.h}, white, {u1, v1}});
+      vertices.push_back({{pen, g.src.h}, white, {u0, v1}});
+    }
+    pen += g.advance;
+  }
+  width = pen;
+}
+
+const string &TextLabel::get_text() { return text; }
+
+float TextLabel::get_width() { return width; }
+
+const vector<SDL_Vertex> &TextLabel::get_vertices() const { return vertices; }
+
+void TextBatch::add(const TextLabel &label, float x, float y,
+                    SDL_FColor color) {
+  const vector<SDL_Vertex> &quads = label.get_vertices();
+  for (size_t q = 0; q < quads.size(); q += 4) {
+    int base = (int)vertices.size();
+    for (size_t k = 0; k < 4; ++k) {
+      SDL_Vertex v = quads[q + k];
+      v.position.x += x;
+      v.position.y += y;
+      v.color = color;
+      vertices.push_back(v);
+    }
+    indices.insert(indices.end(),
+                   {base, base + 1, base + 2, base, base + 2, base + 3});
+  }
+}
+
+void TextBatch::draw(SDL_Renderer *renderer, GlyphAtlas &atlas) {
+  if (!indices.empty())
+    SDL_RenderGeometry(renderer, atlas.get_texture(), vertices.data(),
+                       (int)vertices.size(), indices.data(),
+                       (int)indices.size());
+  vertices.clear();
+  indices.clear();
+}
@@ -0,0 +1,153 @@
+#include "tiled_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+typedef enum {
+  TILE_EMPTY,
+  TILE_OPAQUE,
+  TILE_BLEND,
+} TileClass;
+
+static inline Uint8 alpha_at(const SDL_Surface *s, int x, int y) {
+  // RGBA32 is R, G, B, A in memory on every platform
+  return ((const Uint8 *)s->pixels)[y * s->pitch + x * 4 + 3];
+}
+
+static TileClass classify(const SDL_Surface *s, int x0, int y0, int x1,
+                          int y1) {
+  bool any = false;
+  for (int y = y0; y < y1 && !any; y++)
+    for (int x = x0; x < x1; x++)
+      any |= alpha_at(s, x, y) != 0;
+  if (!any)
+    return TILE_EMPTY;
+
+  // opaque only if the gutter is too, or filtering at the edge would mix
+  // in transparent texels that nothing blends away
+  int gx0 = std::max(x0 - 1, 0), gy0 = std::max(y0 - 1, 0);
+  int gx1 = std::min(x1 + 1, s->w), gy1 = std::min(y1 + 1, s->h);
+  for (int y = gy0; y < gy1; y++)
+    for (int x = gx0; x < gx1; x++)
+      if (alpha_at(s, x, y) != 255)
+        return TILE_BLEND;
+  return TILE_OPAQUE;
+}
+
+// Packs tiles (positions already set) into a square-ish grid of
+// (tile + 2)-pixel cells and fills in each one's atlas rectangle.
+static SDL_Surface *build_atlas(const SDL_Surface *s, int tile,
+                                vector<ImageTile> &tiles) {
+  if (tiles.empty())
+    return nullptr;
+  int cell = tile + 2;
+  int cols = (int)ceilf(sqrtf((float)tiles.size()));
+  int rows = ((int)tiles.size() + cols - 1) / cols;
+  SDL_Surface *atlas =
+      SDL_CreateSurface(cols * cell, rows * cell, SDL_PIXELFORMAT_RGBA32);
+  if (!atlas)
+    return nullptr;
+  memset(atlas->pixels, 0, (size_t)atlas->pitch * atlas->h);
+
+  for (size_t k = 0; k < tiles.size(); k++) {
+    ImageTile &t = tiles[k];
+    int x0 = (int)t.x, y0 = (int)t.y;
+    int w = std::min(tile, s->w - x0), h = std::min(tile, s->h - y0);
+    int cx = (int)(k % cols) * cell, cy = (int)(k / cols) * cell;
+    // one extra pixel all round, clamped to the image like a wrap-free
+    // sampler would
+    for (int dy = -1; dy <= h; dy++) {
+      int sy = std::clamp(y0 + dy, 0, s->h - 1);
+      const Uint32 *src = (const Uint32 *)((const Uint8 *)s->pixels +
+                                           sy * s->pitch);
+      Uint32 *dst = (Uint32 *)((Uint8 *)atlas->pixels +
+                               (cy + 1 + dy) * atlas->pitch) +
+                    cx + 1;
+      for (int dx = -1; dx <= w; dx++)
+        dst[dx] = src[std::clamp(x0 + dx, 0, s->w - 1)];
+    }
+    t.src = {(float)cx + 1, (float)cy + 1, (float)w, (float)h};
+  }
+  return atlas;
+}
+
+bool tile_image(SDL_Surface *image, int tile, TiledImage &out) {
+  SDL_Surface *s = image->format == SDL_PIXELFORMAT_RGBA32
+                       ? image
+                       : SDL_ConvertSurface(image, SDL_PIXELFORMAT_RGBA32);
+  if (!s)
+    return false;
+
+  out.w = s->w;
+  out.h = s->h;
+  out.tile = tile;
+  out.total_tiles = 0;
+  out.opaque_tiles.clear();
+  out.blend_tiles.clear();
+  out.opaque_atlas = nullptr;
+  out.blend_atlas = nullptr;
+  out.opaque_texture = nullptr;
+  out.blend_texture = nullptr;
+
+  for (int y0 = 0; y0 < s->h; y0 += tile) {
+    for (int x0 = 0; x0 < s->w; x0 += tile) {
+      out.total_tiles++;
+      TileClass c = classify(s, x0, y0, std::min(x0 + tile, s->w),
+                             std::min(y0 + tile, s->h));
+      ImageTile t = {{0, 0, 0, 0}, (float)x0, (float)y0};
+      if (c == TILE_OPAQUE)
+        out.opaque_tiles.push_back(t);
+      else if (c == TILE_BLEND)
+        out.blend_tiles.push_back(t);
+    }
+  }
+
+  out.opaque_atlas = build_atlas(s, tile, out.opaque_tiles);
+  out.blend_atlas = build_atlas(s, tile, out.blend_tiles);
+  bool ok = (out.opaque_tiles.empty() || out.opaque_atlas) &&
+            (out.blend_tiles.empty() || out.blend_atlas);
+  if (s != image)
+    SDL_DestroySurface(s);
+  if (!ok)
+    free_tiled_image(out);
+  return ok;
+}
+
+static SDL_Texture *atlas_texture(SDL_Renderer *renderer,
+                                  SDL_Surface *&atlas, SDL_BlendMode mode) {
+  if (!atlas)
+    return nullptr;
+  SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, atlas);
+  SDL_DestroySurface(atlas);
+  atlas = nullptr;
+  if (texture)
+    SDL_SetTextureBlendMode(texture, mode);
+  return texture;
+}
+
+bool upload_tiled_image(SDL_Renderer *renderer, TiledImage &image) {
+  bool want_opaque = image.opaque_atlas != nullptr;
+  bool want_blend = image.blend_atlas != nullptr;
+  image.opaque_texture =
+      atlas_texture(renderer, image.opaque_atlas, SDL_BLENDMODE_NONE);
+  image.blend_texture =
+      atlas_texture(renderer, image.blend_atlas, SDL_BLENDMODE_BLEND);
+  return (!want_opaque || image.opaque_texture) &&
+         (!want_blend || image.blend_texture);
+}
+
+void free_tiled_image(TiledImage &image) {
+  if (image.opaque_atlas)
+    SDL_DestroySurface(image.opaque_atlas);
+  if (image.blend_atlas)
+    SDL_DestroySurface(image.blend_atlas);
+  if (image.opaque_texture)
+    SDL_DestroyTexture(image.opaque_texture);
+  if (image.blend_texture)
+    SDL_DestroyTexture(image.blend_texture);
+  image.opaque_atlas = nullptr;
+  image.blend_atlas = nullptr;
+  image.opaque_texture = nullptr;
+  image.blend_texture = nullptr;
+}
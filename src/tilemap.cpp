@@ -0,0 +1,422 @@
+#include "tilemap.h"
+#include "globals.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+TileMap::TileMap() {
+  io = nullptr;
+  loader = nullptr;
+  memset(&header, 0, sizeof(header));
+  budget = TILEMAP_DEFAULT_BUDGET;
+  frame = 0;
+  loads = 0;
+  origin = {0.0f, 0.0f};
+}
+
+TileMap::~TileMap() { close(); }
+
+bool TileMap::open(const char *path, SDL_Renderer *renderer) {
+  close();
+  io = SDL_IOFromFile(path, "rb");
+  if (!io) {
+    SDL_Log("Failed to open map %s: %s", path, SDL_GetError());
+    return false;
+  }
+
+  Sint64 size = SDL_GetIOSize(io);
+  bool ok = SDL_ReadIO(io, &header, sizeof(header)) == sizeof(header);
+  if (!ok || header.magic != TILEMAP_MAGIC ||
+      header.version != TILEMAP_VERSION ||
+      header.byte_order != TILEMAP_BYTE_ORDER ||
+      header.file_size != (Uint64)size || header.chunk_tiles == 0) {
+    SDL_Log("%s is not a version %u cooked map for this machine", path,
+            TILEMAP_VERSION);
+    close();
+    return false;
+  }
+  // the same sizes cook_tiled_map insists on, and the chunk grid it derives
+  // from them; tile_range and draw divide by and index with all of these
+  Uint64 cs = header.chunk_tiles;
+  if (!header.tile_w || !header.tile_h || !header.width || !header.height ||
+      header.width > INT_MAX || header.height > INT_MAX ||
+      cs * cs > INT_MAX ||
+      header.chunks_x != (header.width + cs - 1) / cs ||
+      header.chunks_y != (header.height + cs - 1) / cs) {
+    SDL_Log("%s: bad map or chunk size", path);
+    close();
+    return false;
+  }
+
+  // every table has to fit in the file before anything is allocated for it;
+  // divided rather than multiplied so a garbage count can't overflow
+  Uint64 room = header.file_size - sizeof(header);
+  Uint64 grid = (Uint64)header.chunks_x * header.chunks_y;
+  if (header.tileset_count > room / sizeof(TileMapTileset) ||
+      header.layer_count > room / sizeof(TileMapLayer) ||
+      header.layer_count > room / sizeof(TileMapChunk) / grid) {
+    SDL_Log("%s: truncated map tables", path);
+    close();
+    return false;
+  }
+
+  size_t chunk_count =
+      (size_t)header.layer_count * header.chunks_y * header.chunks_x;
+  tilesets.resize(header.tileset_count);
+  layers.resize(header.layer_count);
+  chunks.resize(chunk_count);
+  ok = SDL_ReadIO(io, tilesets.data(),
+                  tilesets.size() * sizeof(TileMapTileset)) ==
+           tilesets.size() * sizeof(TileMapTileset) &&
+       SDL_ReadIO(io, layers.data(), layers.size() * sizeof(TileMapLayer)) ==
+           layers.size() * sizeof(TileMapLayer) &&
+       SDL_ReadIO(io, chunks.data(), chunks.size() * sizeof(TileMapChunk)) ==
+           chunks.size() * sizeof(TileMapChunk);
+  for (const TileMapChunk &c : chunks)
+    ok = ok && c.offset + (Uint64)c.runs * 8 <= header.file_size;
+  if (!ok) {
+    SDL_Log("%s: truncated map tables", path);
+    close();
+    return false;
+  }
+  slot_of.assign(chunk_count, -1);
+  requested.assign(chunk_count, 0);
+
+  for (TileMapTileset &ts : tilesets) {
+    ts.image[TILEMAP_PATH_LEN - 1] = '\0';
+    if (!ts.columns || !ts.tile_w || !ts.tile_h || !ts.image_w ||
+        !ts.image_h) {
+      SDL_Log("Tileset %s is missing its size fields", ts.image);
+      close();
+      return false;
+    }
+    SDL_Surface *surface = SDL_LoadPNG(ts.image);
+    if (!surface) {
+      SDL_Log("Failed to load tileset %s", ts.image);
+      close();
+      return false;
+    }
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_DestroySurface(surface);
+    if (!texture) {
+      SDL_Log("Failed to create texture for %s: %s", ts.image,
+              SDL_GetError());
+      close();
+      return false;
+    }
+    SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+    textures.push_back(texture);
+  }
+
+  origin = {0.0f, gGS.winH - FLOOR_HEIGHT -
+                      (float)header.height * header.tile_h};
+  SDL_Log("Opened map %s: %u x %u tiles, %u layers, %zu chunks", path,
+          header.width, header.height, header.layer_count, chunk_count);
+  return true;
+}
+
+void TileMap::close() {
+  // queued and running chunk jobs still use io
+  for (auto &load : pending)
+    while (!load->done.load(memory_order_acquire))
+      SDL_Delay(1);
+  pending.clear();
+  requested.clear();
+  for (SDL_Texture *texture : textures)
+    SDL_DestroyTexture(texture);
+  textures.clear();
+  tilesets.clear();
+  layers.clear();
+  chunks.clear();
+  slot_of.clear();
+  slots.clear();
+  if (io)
+    SDL_CloseIO(io);
+  io = nullptr;
+}
+
+bool TileMap::is_open() { return io != nullptr; }
+
+void TileMap::set_budget(size_t bytes) { budget = bytes; }
+
+void TileMap::set_origin(SDL_FPoint origin) { this->origin = origin; }
+
+void TileMap::set_loader(AssetLoader *loader) { this->loader = loader; }
+
+void TileMap::read_chunk(ChunkLoad &load) {
+  vector<Uint32> runs(load.table.runs * 2);
+  {
+    lock_guard<mutex> lk(io_lock);
+    load.ok = SDL_SeekIO(io, (Sint64)load.table.offset, SDL_IO_SEEK_SET) >= 0 &&
+              SDL_ReadIO(io, runs.data(), runs.size() * sizeof(Uint32)) ==
+                  runs.size() * sizeof(Uint32);
+  }
+  if (!load.ok) {
+    SDL_Log("Failed to read map chunk %d: %s", load.chunk, SDL_GetError());
+    load.done.store(true, memory_order_release);
+    return;
+  }
+
+  size_t n = (size_t)header.chunk_tiles * header.chunk_tiles;
+  load.tiles.resize(n);
+  size_t k = 0;
+  for (Uint32 r = 0; r < load.table.runs; r++) {
+    size_t count = std::min((size_t)runs[2 * r], n - k);
+    std::fill_n(load.tiles.begin() + k, count, runs[2 * r + 1]);
+    k += count;
+  }
+  std::fill(load.tiles.begin() + k, load.tiles.end(), 0u);
+  load.done.store(true, memory_order_release);
+}
+
+void TileMap::request_chunk(int chunk) {
+  auto load = make_unique<ChunkLoad>();
+  load->chunk = chunk;
+  load->table = chunks[chunk];
+  load->ok = false;
+  load->done = false;
+  ChunkLoad *job = load.get();
+  pending.push_back(std::move(load));
+  requested[chunk] = 1;
+  if (loader)
+    loader->run([this, job] { read_chunk(*job); });
+  else
+    read_chunk(*job);
+}
+
+// Reuses the least recently used slot not needed this frame, or grows past
+// the budget when the view alone needs more.
+int TileMap::take_slot(size_t max_slots) {
+  int s = -1;
+  if (slots.size() >= max_slots) {
+    for (int k = 0; k < (int)slots.size(); k++) {
+      if (slots[k].last_used < frame &&
+          (s < 0 || slots[k].last_used < slots[s].last_used))
+        s = k;
+    }
+  }
+  if (s < 0) {
+    s = (int)slots.size();
+    slots.push_back({-1, 0, {}});
+  } else if (slots[s].chunk >= 0) {
+    slot_of[slots[s].chunk] = -1;
+  }
+  return s;
+}
+
+void TileMap::install_loads(size_t max_slots) {
+  for (size_t k = 0; k < pending.size();) {
+    ChunkLoad &load = *pending[k];
+    if (!load.done.load(memory_order_acquire)) {
+      k++;
+      continue;
+    }
+    requested[load.chunk] = 0;
+    if (load.ok) {
+      int s = take_slot(max_slots);
+      slots[s].chunk = load.chunk;
+      slots[s].last_used = frame;
+      slots[s].tiles.swap(load.tiles);
+      slot_of[load.chunk] = s;
+      loads++;
+    } else {
+      // drawn empty from now on rather than read again every frame
+      chunks[load.chunk].runs = 0;
+    }
+    pending[k] = std::move(pending.back());
+    pending.pop_back();
+  }
+}
+
+bool TileMap::tile_range(const TileMapLayer &layer, const SDL_FRect &view,
+                         int &tx0, int &ty0, int &tx1, int &ty1) {
+  float left = origin.x + layer.offset_x;
+  float top = origin.y + layer.offset_y;
+  // tiles from a tileset taller or wider than the grid stick out up and
+  // right of their cell, so widen the range by the biggest overhang
+  float over_w = 0.0f, over_h = 0.0f;
+  for (const TileMapTileset &ts : tilesets) {
+    over_w = std::max(over_w, (float)ts.tile_w - header.tile_w);
+    over_h = std::max(over_h, (float)ts.tile_h - header.tile_h);
+  }
+  tx0 = std::max((int)floorf((view.x - over_w - left) / header.tile_w), 0);
+  ty0 = std::max((int)floorf((view.y - top) / header.tile_h), 0);
+  tx1 = std::min((int)floorf((view.x + view.w - left) / header.tile_w),
+                 (int)header.width - 1);
+  ty1 = std::min((int)floorf((view.y + view.h + over_h - top) / header.tile_h),
+                 (int)header.height - 1);
+  return tx0 <= tx1 && ty0 <= ty1;
+}
+
+void TileMap::stream(Camera &camera) {
+  loads = 0;
+  if (!io)
+    return;
+  frame++;
+
+  size_t chunk_bytes =
+      (size_t)header.chunk_tiles * header.chunk_tiles * sizeof(Uint32);
+  size_t max_slots = std::max(budget / chunk_bytes, (size_t)1);
+  SDL_FRect view = camera.get_view();
+  int cs = (int)header.chunk_tiles;
+
+  for (int l = 0; l < (int)layers.size(); l++) {
+    if (!layers[l].visible)
+      continue;
+    int tx0, ty0, tx1, ty1;
+    if (!tile_range(layers[l], view, tx0, ty0, tx1, ty1))
+      continue;
+    int cx0 = std::max(tx0 / cs - TILEMAP_PREFETCH_CHUNKS, 0);
+    int cy0 = std::max(ty0 / cs - TILEMAP_PREFETCH_CHUNKS, 0);
+    int cx1 = std::min(tx1 / cs + TILEMAP_PREFETCH_CHUNKS,
+                       (int)header.chunks_x - 1);
+    int cy1 = std::min(ty1 / cs + TILEMAP_PREFETCH_CHUNKS,
+                       (int)header.chunks_y - 1);
+
+    for (int cy = cy0; cy <= cy1; cy++) {
+      for (int cx = cx0; cx <= cx1; cx++) {
+        int chunk = (l * header.chunks_y + cy) * header.chunks_x + cx;
+        if (chunks[chunk].runs == 0)
+          continue;
+        if (slot_of[chunk] >= 0)
+          slots[slot_of[chunk]].last_used = frame;
+        else if (!requested[chunk])
+          request_chunk(chunk);
+      }
+    }
+  }
+  install_loads(max_slots);
+
+  // give back whatever a big view pushed over the budget once it's unused
+  for (int k = (int)slots.size() - 1;
+       k >= 0 && slots.size() > max_slots; k--) {
+    if (slots[k].last_used == frame)
+      continue;
+    if (slots[k].chunk >= 0)
+      slot_of[slots[k].chunk] = -1;
+    if (k != (int)slots.size() - 1) {
+      slots[k] = std::move(slots.back());
+      if (slots[k].chunk >= 0)
+        slot_of[slots[k].chunk] = k;
+    }
+    slots.pop_back();
+  }
+}
+
+int TileMap::tileset_for(Uint32 gid) {
+  for (int t = (int)tilesets.size() - 1; t >= 0; t--)
+    if (gid >= tilesets[t].first_gid)
+      return t;
+  return -1;
+}
+
+void TileMap::flush(SDL_Renderer *renderer, SDL_Texture *texture) {
+  if (!indices.empty())
+    SDL_RenderGeometry(renderer, texture, vertices.data(),
+                       (int)vertices.size(), indices.data(),
+                       (int)indices.size());
+  vertices.clear();
+  indices.clear();
+}
+
+void TileMap::draw(SDL_Renderer *renderer, Camera &camera) {
+  if (!io)
+    return;
+
+  SDL_FRect view = camera.get_view();
+  int cs = (int)header.chunk_tiles;
+  int current = -1; // tileset of the batch being built
+
+  for (int l = 0; l < (int)layers.size(); l++) {
+    const TileMapLayer &layer = layers[l];
+    int tx0, ty0, tx1, ty1;
+    if (!layer.visible || !tile_range(layer, view, tx0, ty0, tx1, ty1))
+      continue;
+
+    SDL_FColor color = {1.0f, 1.0f, 1.0f, layer.opacity};
+    float left = origin.x + layer.offset_x - view.x;
+    float top = origin.y + layer.offset_y - view.y;
+
+    for (int cy = ty0 / cs; cy <= ty1 / cs; cy++) {
+      for (int cx = tx0 / cs; cx <= tx1 / cs; cx++) {
+        int chunk = (l * header.chunks_y + cy) * header.chunks_x + cx;
+        if (slot_of[chunk] < 0)
+          continue; // empty, or not streamed in yet
+        const Uint32 *tiles = slots[slot_of[chunk]].tiles.data();
+
+        int y0 = std::max(ty0, cy * cs), y1 = std::min(ty1, cy * cs + cs - 1);
+        int x0 = std::max(tx0, cx * cs), x1 = std::min(tx1, cx * cs + cs - 1);
+        for (int ty = y0; ty <= y1; ty++) {
+          for (int tx = x0; tx <= x1; tx++) {
+            Uint32 raw = tiles[(ty - cy * cs) * cs + (tx - cx * cs)];
+            Uint32 gid = raw & TILEMAP_GID_MASK;
+            if (gid == 0)
+              continue;
+            int t = tileset_for(gid);
+            if (t < 0)
+              continue;
+            if (t != current) {
+              if (current >= 0)
+                flush(renderer, textures[current]);
+              current = t;
+            }
+
+            const TileMapTileset &ts = tilesets[t];
+            Uint32 id = gid - ts.first_gid;
+            float sx = (float)(ts.margin + (id % ts.columns) *
+                                               (ts.tile_w + ts.spacing));
+            float sy = (float)(ts.margin + (id / ts.columns) *
+                                               (ts.tile_h + ts.spacing));
+            float u0 = sx / ts.image_w, u1 = (sx + ts.tile_w) / ts.image_w;
+            float v0 = sy / ts.image_h, v1 = (sy + ts.tile_h) / ts.image_h;
+
+            // corners tl, tr, bl, br; Tiled applies the diagonal flip
+            // first, then horizontal and vertical
+            SDL_FPoint uv[4] = {{u0, v0}, {u1, v0}, {u0, v1}, {u1, v1}};
+            if (raw & TILEMAP_FLIP_D)
+              std::swap(uv[1], uv[2]);
+            if (raw & TILEMAP_FLIP_H) {
+              std::swap(uv[0], uv[1]);
+              std::swap(uv[2], uv[3]);
+            }
+            if (raw & TILEMAP_FLIP_V) {
+              std::swap(uv[0], uv[2]);
+              std::swap(uv[1], uv[3]);
+            }
+
+            // tiles are anchored to the bottom-left of their cell
+            float x = left + tx * (float)header.tile_w;
+            float y = top + (ty + 1) * (float)header.tile_h - ts.tile_h;
+            float w = (float)ts.tile_w, h = (float)ts.tile_h;
+            int base = (int)vertices.size();
+            vertices.push_back({{x, y}, color, uv[0]});
+            vertices.push_back({{x + w, y}, color, uv[1]});
+            vertices.push_back({{x, y + h}, color, uv[2]});
+            vertices.push_back({{x + w, y + h}, color, uv[3]});
+            int quad[] = {base, base + 1, base + 2, base + 1, base + 3, base + 2};
+            indices.insert(indices.end(), quad, quad + 6);
+          }
+        }
+      }
+    }
+  }
+  if (current >= 0)
+    flush(renderer, textures[current]);
+}
+
+int TileMap::get_resident_chunks() {
+  int n = 0;
+  for (const Slot &s : slots)
+    n += s.chunk >= 0;
+  return n;
+}
+
+size_t TileMap::get_resident_bytes() {
+  return slots.size() * (size_t)header.chunk_tiles * header.chunk_tiles *
+         sizeof(Uint32);
+}
+
+int TileMap::get_loads() { return loads; }
@@ -0,0 +1,314 @@
+#include "json.h"
+#include "tilemap.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+typedef struct {
+  TileMapLayer info;
+  vector<Uint32> gids; // width * height, row by row
+} CookLayer;
+
+static bool load_json(const string &path, JsonValue &doc) {
+  size_t size;
+  char *text = (char *)SDL_LoadFile(path.c_str(), &size);
+  if (!text) {
+    SDL_Log("Failed to read %s: %s", path.c_str(), SDL_GetError());
+    return false;
+  }
+  string error;
+  bool ok = json_parse(text, size, doc, error);
+  SDL_free(text);
+  if (!ok)
+    SDL_Log("%s: %s", path.c_str(), error.c_str());
+  return ok;
+}
+
+static string dir_of(const string &path) {
+  size_t slash = path.find_last_of("/\\");
+  return slash == string::npos ? "" : path.substr(0, slash + 1);
+}
+
+static bool ends_with(const string &s, const char *suffix) {
+  size_t n = strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+static int base64_value(char c) {
+  if (c >= 'A' && c <= 'Z')
+    return c - 'A';
+  if (c >= 'a' && c <= 'z')
+    return c - 'a' + 26;
+  if (c >= '0' && c <= '9')
+    return c - '0' + 52;
+  if (c == '+')
+    return 62;
+  if (c == '/')
+    return 63;
+  return -1;
+}
+
+static vector<Uint8> base64_decode(const string &text) {
+  vector<Uint8> out;
+  Uint32 acc = 0;
+  int bits = 0;
+  for (char c : text) {
+    int v = base64_value(c);
+    if (v < 0)
+      continue; // padding and whitespace
+    acc = (acc << 6) | v;
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out.push_back((Uint8)(acc >> bits));
+    }
+  }
+  return out;
+}
+
+static bool read_tileset(const JsonValue &entry, const string &map_dir,
+                         TileMapTileset &out) {
+  memset(&out, 0, sizeof(out));
+  out.first_gid = (Uint32)entry.get_number("firstgid", 1);
+
+  // external tilesets are resolved relative to the map, their images
+  // relative to the tileset
+  JsonValue external;
+  const JsonValue *ts = &entry;
+  string dir = map_dir;
+  if (const char *source = entry.get_string("source", nullptr)) {
+    string path = map_dir + source;
+    if (!ends_with(path, ".tsj") && !ends_with(path, ".json")) {
+      SDL_Log("%s: only JSON tilesets are supported; export it as .tsj",
+              path.c_str());
+      return false;
+    }
+    if (!load_json(path, external))
+      return false;
+    ts = &external;
+    dir = dir_of(path);
+  }
+
+  const char *image = ts->get_string("image", nullptr);
+  if (!image) {
+    SDL_Log("Tileset %s has no single image; image collections aren't "
+            "supported",
+            ts->get_string("name", "?"));
+    return false;
+  }
+  string image_path = dir + image;
+  if (image_path.size() >= TILEMAP_PATH_LEN) {
+    SDL_Log("Tileset image path too long: %s", image_path.c_str());
+    return false;
+  }
+  SDL_strlcpy(out.image, image_path.c_str(), TILEMAP_PATH_LEN);
+  out.tile_count = (Uint32)ts->get_number("tilecount", 0);
+  out.columns = (Uint32)ts->get_number("columns", 0);
+  out.tile_w = (Uint32)ts->get_number("tilewidth", 0);
+  out.tile_h = (Uint32)ts->get_number("tileheight", 0);
+  out.margin = (Uint32)ts->get_number("margin", 0);
+  out.spacing = (Uint32)ts->get_number("spacing", 0);
+  out.image_w = (Uint32)ts->get_number("imagewidth", 0);
+  out.image_h = (Uint32)ts->get_number("imageheight", 0);
+  if (!out.columns || !out.tile_w || !out.tile_h || !out.image_w ||
+      !out.image_h) {
+    SDL_Log("Tileset %s is missing its size fields", image_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+static bool read_tile_data(const JsonValue &layer, size_t n,
+                           vector<Uint32> &gids) {
+  const JsonValue *data = layer.get("data");
+  const char *name = layer.get_string("name", "?");
+  gids.assign(n, 0);
+  if (data && data->type == JSON_ARRAY) {
+    for (size_t k = 0; k < n && k < data->items.size(); k++)
+      gids[k] = (Uint32)data->items[k].number;
+    return true;
+  }
+  if (data && data->type == JSON_STRING &&
+      strcmp(layer.get_string("encoding", ""), "base64") == 0) {
+    if (layer.get_string("compression", "")[0]) {
+      SDL_Log("Layer %s is compressed; save the map with uncompressed "
+              "base64 or CSV tile data",
+              name);
+      return false;
+    }
+    vector<Uint8> bytes = base64_decode(data->str);
+    for (size_t k = 0; k < n && 4 * k + 3 < bytes.size(); k++)
+      gids[k] = bytes[4 * k] | bytes[4 * k + 1] << 8 |
+                bytes[4 * k + 2] << 16 | (Uint32)bytes[4 * k + 3] << 24;
+    return true;
+  }
+  SDL_Log("Layer %s has no tile data", name);
+  return false;
+}
+
+// Flattens group layers into their tile layers, folding the groups'
+// visibility, opacity and offsets into each child.
+static bool read_layers(const JsonValue &list, const TileMapLayer &parent,
+                        int width, int height, vector<CookLayer> &out) {
+  for (const JsonValue &layer : list.items) {
+    TileMapLayer info = {};
+    SDL_strlcpy(info.name, layer.get_string("name", ""), TILEMAP_NAME_LEN);
+    info.opacity = parent.opacity * (float)layer.get_number("opacity", 1.0);
+    info.offset_x = parent.offset_x + (float)layer.get_number("offsetx", 0.0);
+    info.offset_y = parent.offset_y + (float)layer.get_number("offsety", 0.0);
+    info.visible = parent.visible && layer.get_bool("visible", true);
+
+    const char *type = layer.get_string("type", "");
+    if (strcmp(type, "group") == 0) {
+      const JsonValue *children = layer.get("layers");
+      if (children && !read_layers(*children, info, width, height, out))
+        return false;
+    } else if (strcmp(type, "tilelayer") == 0) {
+      CookLayer cooked;
+      cooked.info = info;
+      if (!read_tile_data(layer, (size_t)width * height, cooked.gids))
+        return false;
+      out.push_back(std::move(cooked));
+    }
+    // object and image layers carry nothing the game draws yet
+  }
+  return true;
+}
+
+bool cook_tiled_map(const char *json_path, const char *out_path,
+                    int chunk_tiles) {
+  string path = json_path;
+  if (ends_with(path, ".tmx")) {
+    SDL_Log("%s: export the map as JSON (.tmj) to cook it", json_path);
+    return false;
+  }
+  JsonValue map;
+  if (!load_json(path, map))
+    return false;
+  if (map.get_bool("infinite", false) ||
+      strcmp(map.get_string("orientation", "orthogonal"), "orthogonal") != 0) {
+    SDL_Log("%s: only fixed-size orthogonal maps can be cooked", json_path);
+    return false;
+  }
+
+  int width = (int)map.get_number("width", 0);
+  int height = (int)map.get_number("height", 0);
+  int tile_w = (int)map.get_number("tilewidth", 0);
+  int tile_h = (int)map.get_number("tileheight", 0);
+  if (width <= 0 || height <= 0 || tile_w <= 0 || tile_h <= 0 ||
+      chunk_tiles <= 0) {
+    SDL_Log("%s: bad map or chunk size", json_path);
+    return false;
+  }
+
+  string map_dir = dir_of(path);
+  vector<TileMapTileset> tilesets;
+  if (const JsonValue *list = map.get("tilesets")) {
+    for (const JsonValue &entry : list->items) {
+      tilesets.emplace_back();
+      if (!read_tileset(entry, map_dir, tilesets.back()))
+        return false;
+    }
+  }
+  // TileMap looks tiles up by the last tileset starting at or below a gid
+  std::sort(tilesets.begin(), tilesets.end(),
+            [](const TileMapTileset &a, const TileMapTileset &b) {
+              return a.first_gid < b.first_gid;
+            });
+
+  vector<CookLayer> layers;
+  TileMapLayer root = {};
+  root.opacity = 1.0f;
+  root.visible = 1;
+  if (const JsonValue *list = map.get("layers"))
+    if (!read_layers(*list, root, width, height, layers))
+      return false;
+
+  TileMapHeader header = {};
+  header.magic = TILEMAP_MAGIC;
+  header.version = TILEMAP_VERSION;
+  header.byte_order = TILEMAP_BYTE_ORDER;
+  header.tile_w = tile_w;
+  header.tile_h = tile_h;
+  header.width = width;
+  header.height = height;
+  header.chunk_tiles = chunk_tiles;
+  header.chunks_x = (width + chunk_tiles - 1) / chunk_tiles;
+  header.chunks_y = (height + chunk_tiles - 1) / chunk_tiles;
+  header.tileset_count = (Uint32)tilesets.size();
+  header.layer_count = (Uint32)layers.size();
+
+  // run-length encode every chunk; the payloads follow the tables
+  size_t chunk_count = layers.size() * header.chunks_y * header.chunks_x;
+  vector<TileMapChunk> chunks(chunk_count);
+  vector<Uint32> payload;
+  Uint64 offset = sizeof(header) + tilesets.size() * sizeof(TileMapTileset) +
+                  layers.size() * sizeof(TileMapLayer) +
+                  chunk_count * sizeof(TileMapChunk);
+  size_t non_empty = 0;
+  for (size_t l = 0; l < layers.size(); l++) {
+    const vector<Uint32> &gids = layers[l].gids;
+    for (Uint32 cy = 0; cy < header.chunks_y; cy++) {
+      for (Uint32 cx = 0; cx < header.chunks_x; cx++) {
+        TileMapChunk &chunk = chunks[(l * header.chunks_y + cy) *
+                                         header.chunks_x + cx];
+        chunk.offset = offset + payload.size() * sizeof(Uint32);
+        size_t first_run = payload.size();
+        for (int y = 0; y < chunk_tiles; y++) {
+          for (int x = 0; x < chunk_tiles; x++) {
+            int tx = cx * chunk_tiles + x, ty = cy * chunk_tiles + y;
+            Uint32 gid = tx < width && ty < height
+                             ? gids[(size_t)ty * width + tx]
+                             : 0;
+            chunk.tiles += (gid & TILEMAP_GID_MASK) != 0;
+            if (payload.size() > first_run && payload.back() == gid) {
+              payload[payload.size() - 2]++;
+            } else {
+              payload.push_back(1);
+              payload.push_back(gid);
+            }
+          }
+        }
+        if (chunk.tiles == 0) {
+          payload.resize(first_run);
+          chunk.offset = 0;
+          continue;
+        }
+        chunk.runs = (Uint32)((payload.size() - first_run) / 2);
+        non_empty++;
+      }
+    }
+  }
+  header.file_size = offset + payload.size() * sizeof(Uint32);
+
+  SDL_IOStream *io = SDL_IOFromFile(out_path, "wb");
+  if (!io) {
+    SDL_Log("Failed to open %s for writing: %s", out_path, SDL_GetError());
+    return false;
+  }
+  bool ok = SDL_WriteIO(io, &header, sizeof(header)) == sizeof(header);
+  ok = ok && SDL_WriteIO(io, tilesets.data(),
+                         tilesets.size() * sizeof(TileMapTileset)) ==
+                 tilesets.size() * sizeof(TileMapTileset);
+  for (const CookLayer &layer : layers)
+    ok = ok && SDL_WriteIO(io, &layer.info, sizeof(TileMapLayer)) ==
+                   sizeof(TileMapLayer);
+  ok = ok && SDL_WriteIO(io, chunks.data(),
+                         chunks.size() * sizeof(TileMapChunk)) ==
+                 chunks.size() * sizeof(TileMapChunk);
+  ok = ok && SDL_WriteIO(io, payload.data(), payload.size() * sizeof(Uint32)) ==
+                 payload.size() * sizeof(Uint32);
+  ok = SDL_CloseIO(io) && ok;
+  if (!ok) {
+    SDL_Log("Failed to write %s", out_path);
+    return false;
+  }
+
+  SDL_Log("Cooked %s: %d x %d tiles, %zu layers, %zu of %zu chunks "
+          "non-empty, %llu bytes",
+          json_path, width, height, layers.size(), non_empty, chunk_count,
+          (unsigned long long)header.file_size);
+  return true;
+}
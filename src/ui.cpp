@@ -1,67 +1,110 @@
 #include "ui.h"
-#include "SDL3/SDL_surface.h"
 #include "globals.h"
+#include "profiler.h"
 
+#include <algorithm>
+#include <cmath>
 #include <format>
 #include <system_error>
 
-UI::UI() {
+UI::UI(AssetLoader &assets) : assets(assets) {
   if (!TTF_Init()) {
     throw std::runtime_error(std::string("TTF_Init failed: ") + SDL_GetError());
   }
 
-  font =
-      TTF_OpenFont("assets/fonts/JetBrainsMonoNerdFontMono-ExtraBold.ttf", 24);
-  if (!font) {
-    SDL_Log("Failed to load font: %s", SDL_GetError());
-  }
-}
-
-UI::~UI() {
-  if (font)
-    TTF_CloseFont(font);
+  font = assets.load_font(
+      "assets/fonts/JetBrainsMonoNerdFontMono-ExtraBold.ttf", 24);
 }
 
-void UI::draw(SDL_Renderer *renderer) {
-  SDL_Color white{255, 255, 255, 255};
+// The loader owns the font
+UI::~UI() {}
 
-  // ------- ALTITUDE -------
-  int altitude = gGS.altitude;
-  std::string alt_text = std::to_string(altitude) + " m";
+void UI::toggle_profiler() { show_profiler = !show_profiler; }
 
-  SDL_Surface *s1 = TTF_RenderText_Blended(font, alt_text.c_str(), 0, white);
-  if (!s1)
-    return;
+void UI::draw_profiler(SDL_Renderer *renderer) {
+  const float graph_w = 2.0f * PROFILER_FRAME_HISTORY;
+  const float graph_h = 100.0f;
+  const float max_ms = 33.3f; // top of the graph is two frame budgets
+  const float left = 10.0f;
+  const float bottom = gGS.winH - 10.0f;
 
-  SDL_Texture *t1 = SDL_CreateTextureFromSurface(renderer, s1);
-  SDL_DestroySurface(s1);
+  float history[PROFILER_FRAME_HISTORY];
+  int n = profiler_frame_history(history, PROFILER_FRAME_HISTORY);
 
-  int w1 = t1->w;
-  int h1 = t1->h;
+  SDL_FRect panel{left, bottom - graph_h, graph_w, graph_h};
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+  SDL_RenderFillRect(renderer, &panel);
 
-  SDL_FRect dst1{gGS.winW - w1 - 10.0f, 10.0f, (float)w1, (float)h1};
+  // 16.6 ms budget line
+  float budget_y = bottom - graph_h * (16.6f / max_ms);
+  SDL_SetRenderDrawColor(renderer, 200, 80, 80, 255);
+  SDL_RenderLine(renderer, left, budget_y, left + graph_w, budget_y);
 
-  SDL_RenderTexture(renderer, t1, nullptr, &dst1);
-  SDL_DestroyTexture(t1);
+  SDL_FPoint points[PROFILER_FRAME_HISTORY];
+  for (int i = 0; i < n; ++i) {
+    float ms = std::min(history[i], max_ms);
+    points[i] = {left + 2.0f * i, bottom - graph_h * (ms / max_ms)};
+  }
+  SDL_SetRenderDrawColor(renderer, 80, 220, 120, 255);
+  if (n > 1)
+    SDL_RenderLines(renderer, points, n);
+
+  FrameStats stats = profiler_frame_stats();
+  profiler_label.set_text(
+      atlas, std::format("{:.1f} ms  p50 {:.1f}  p99 {:.1f}  max {:.1f}",
+                         stats.last_ms, stats.p50_ms, stats.p99_ms,
+                         stats.max_ms));
+  text_batch.add(profiler_label, left,
+                 bottom - graph_h - atlas.get_line_height() - 4.0f,
+                 {1.0f, 1.0f, 1.0f, 1.0f});
+}
 
-  // ------- SPEED -------
-  float speed = gGS.speed;
-  std::string speed_text = std::format("{:.2f} m/s", speed);
+void UI::draw(SDL_Renderer *renderer, int altitude, float speed,
+              float latency_ms) {
+  if (!atlas.ready()) {
+    TTF_Font *loaded = assets.get_font(font);
+    if (!loaded || !atlas.build(renderer, loaded))
+      return;
+  }
 
-  SDL_Surface *s2 = TTF_RenderText_Blended(font, speed_text.c_str(), 0, white);
-  if (!s2)
-    return;
+  SDL_FColor white{1.0f, 1.0f, 1.0f, 1.0f};
 
-  SDL_Texture *t2 = SDL_CreateTextureFromSurface(renderer, s2);
-  SDL_DestroySurface(s2);
+  // ------- ALTITUDE -------
+  if (altitude != shown_altitude || altitude_label.get_text().empty()) {
+    shown_altitude = altitude;
+    altitude_label.set_text(atlas, std::to_string(altitude) + " m");
+  }
 
-  int w2 = t2->w;
-  int h2 = t2->h;
+  // ------- SPEED -------
+  int speed_centi = (int)lroundf(speed * 100.0f);
+  if (speed_centi != shown_speed_centi || speed_label.get_text().empty()) {
+    shown_speed_centi = speed_centi;
+    speed_label.set_text(atlas, std::format("{:.2f} m/s", speed));
+  }
 
-  SDL_FRect dst2{gGS.winW - w2 - 10.0f,
-                 10.0f + h1 + 5.0f, // <-- put below altitude
-                 (float)w2, (float)h2};
+  // ------- INPUT LATENCY -------
+  int latency_deci = latency_ms < 0.0f ? -1 : (int)lroundf(latency_ms * 10.0f);
+  if (latency_deci != shown_latency_deci) {
+    shown_latency_deci = latency_deci;
+    latency_label.set_text(
+        atlas, latency_deci < 0 ? std::string()
+                                : std::format("input {:.1f} ms", latency_ms));
+  }
 
-  SDL_RenderTexture(renderer, t2, nullptr, &dst2);
-  SDL_DestroyTexture(t2);
+  float line_h = atlas.get_line_height();
+  text_batch.add(altitude_label, gGS.winW - altitude_label.get_width() - 10.0f,
+                 10.0f, white);
+  text_batch.add(speed_label, gGS.winW - speed_label.get_width() - 10.0f,
+                 10.0f + line_h + 5.0f, // <-- put below altitude
+                 white);
+  if (latency_deci >= 0)
+    text_batch.add(latency_label,
+                   gGS.winW - latency_label.get_width() - 10.0f,
+                   10.0f + 2.0f * (line_h + 5.0f), white);
+
+  if (show_profiler)
+    draw_profiler(renderer);
+
+  text_batch.draw(renderer, atlas);
 }
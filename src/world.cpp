@@ -1,84 +1,125 @@
 #include "world.h"
 #include "globals.h"
 
-bool Background::load(SDL_Renderer *renderer) {
+void Background::load() {
   for (int i = 0; i < 6; ++i) {
     BGLayer layer;
-
-    SDL_Surface *surface = SDL_LoadPNG(layerFiles[i]);
-    if (!surface) {
-      SDL_Log("Failed to load %s", layerFiles[i]);
-      return false;
-    }
-
-    layer.texture = SDL_CreateTextureFromSurface(renderer, surface);
-    if (!layer.texture) {
-      SDL_Log("Failed to create texture for %s: %s", layerFiles[i],
-              SDL_GetError());
-      return false;
-    }
-
+    layer.image = assets.load_tiled_image(layerFiles[i], BG_TILE_SIZE);
+    layer.tiles = nullptr;
     layer.scrollSpeed = scrollSpeeds[i];
     layer.offsetX = 0.0f;
     layer.offsetY = 0.0f;
+    layer.drawW = 0.0f;
+    layer.drawH = 0.0f;
     layers[i] = layer;
-
-    float w, h;
-    SDL_GetTextureSize(layer.texture, &w, &h);
-    SDL_Log("Loaded %s: (%f x %f)", layerFiles[i], w, h);
   }
+}
+
+Background::Background(AssetLoader &assets) : assets(assets) { load(); }
+
+// The loader owns the layer tiles
+Background::~Background() {}
+
+bool Background::resolve(BGLayer &layer) {
+  if (layer.tiles)
+    return true;
+  layer.tiles = assets.get_tiled_image(layer.image);
+  if (!layer.tiles)
+    return false;
+  layer.drawW = layer.tiles->w * layerScale;
+  layer.drawH = layer.tiles->h * layerScale;
   return true;
 }
 
-Background::Background(SDL_Renderer *renderer) {
-  bool result = load(renderer);
-  if (result)
-    SDL_Log("Background layers loaded!");
+void Background::add_tiles(const BGLayer &layer,
+                           const std::vector<ImageTile> &tiles,
+                           SDL_Texture *texture, float left, float top,
+                           std::vector<SDL_Vertex> &out) {
+  if (!texture)
+    return;
+  float texW, texH;
+  SDL_GetTextureSize(texture, &texW, &texH);
+  const SDL_FColor white = {1.0f, 1.0f, 1.0f, 1.0f};
+
+  // Compute how many horizontal repeats are needed
+  int tilesX = (int)ceil(gGS.winW / layer.drawW) + 1;
+  for (const ImageTile &t : tiles) {
+    float y0 = top + t.y * layerScale;
+    float y1 = y0 + t.src.h * layerScale;
+    if (y1 <= 0.0f || y0 >= gGS.winH)
+      continue;
+    float u0 = t.src.x / texW, u1 = (t.src.x + t.src.w) / texW;
+    float v0 = t.src.y / texH, v1 = (t.src.y + t.src.h) / texH;
+    for (int x = 0; x < tilesX; ++x) {
+      float x0 = left + x * layer.drawW + t.x * layerScale;
+      float x1 = x0 + t.src.w * layerScale;
+      if (x1 <= 0.0f || x0 >= gGS.winW)
+        continue;
+      out.push_back({{x0, y0}, white, {u0, v0}});
+      out.push_back({{x1, y0}, white, {u1, v0}});
+      out.push_back({{x0, y1}, white, {u0, v1}});
+      out.push_back({{x1, y1}, white, {u1, v1}});
+    }
+  }
 }
 
-Background::~Background() {
-  for (auto &layer : layers)
-    SDL_DestroyTexture(layer.texture);
+void Background::submit(SDL_Renderer *renderer, SDL_Texture *texture,
+                        const std::vector<SDL_Vertex> &vertices) {
+  if (vertices.empty())
+    return;
+  int quads = (int)vertices.size() / 4;
+  for (int q = (int)indices.size() / 6; q < quads; ++q) {
+    int quad[] = {4 * q, 4 * q + 1, 4 * q + 2, 4 * q + 1, 4 * q + 3, 4 * q + 2};
+    indices.insert(indices.end(), quad, quad + 6);
+  }
+  SDL_RenderGeometry(renderer, texture, vertices.data(), (int)vertices.size(),
+                     indices.data(), quads * 6);
 }
 
 void Background::draw(SDL_Renderer *renderer, Camera &camera) {
-  for (auto &layer : layers) {
-    float texW, texH;
-    SDL_GetTextureSize(layer.texture, &texW, &texH);
+  Uint8 r, g, b, a;
+  SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+  SDL_FPoint camera_pos = camera.get_pos();
+  float camMinY = gGS.winH / 2.0f;
 
-    float scale = 1.5f; // static_cast<float>(gGS.winW) / texW;
-    float drawW = texW * scale;
-    float drawH = texH * scale;
-
-    SDL_FPoint camera_pos = camera.get_pos();
+  for (int i = 0; i < 6; ++i) {
+    BGLayer &layer = layers[i];
+    if (!resolve(layer)) {
+      // nearer layers cover less of the screen, so the stand-ins step down
+      // from the top like the finished skyline would
+      const SDL_Color &c = placeholderColors[i];
+      SDL_FRect band = {0.0f, gGS.winH * i / 8.0f, (float)gGS.winW,
+                        gGS.winH * (8 - i) / 8.0f};
+      SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+      SDL_RenderFillRect(renderer, &band);
+      continue;
+    }
 
     float scrollFactor = layer.scrollSpeed;
 
     // Horizontal parallax
-    layer.offsetX = fmodf(scrollFactor * camera_pos.x, drawW);
+    layer.offsetX = fmodf(scrollFactor * camera_pos.x, layer.drawW);
     if (layer.offsetX < 0)
-      layer.offsetX += drawW;
+      layer.offsetX += layer.drawW;
 
     // Vertical parallax: adjust relative to camera's minimum y
-    float camMinY = gGS.winH / 2.0f;
     layer.offsetY = scrollFactor * (camera_pos.y - camMinY);
 
     // Base position aligns bottom edge when camera at minY
-    float baseY = gGS.winH - drawH;
+    float baseY = gGS.winH - layer.drawH;
     float drawY = baseY - layer.offsetY;
-
-    SDL_FRect src = {0, 0, texW, texH};
-
-    // Compute how many horizontal tiles are needed
-    int tilesX = (int)ceil(gGS.winW / drawW) + 1;
-
-    for (int x = 0; x < tilesX; ++x) {
-      SDL_FRect dest;
-      dest.x = -layer.offsetX + x * drawW; // horizontal tiling
-      dest.y = drawY;                      // vertical fixed
-      dest.w = drawW;
-      dest.h = drawH;
-      SDL_RenderTexture(renderer, layer.texture, &src, &dest);
-    }
+    if (drawY >= gGS.winH || drawY + layer.drawH <= 0.0f)
+      continue;
+
+    const TiledImage &tiles = *layer.tiles;
+    opaqueVertices.clear();
+    blendVertices.clear();
+    add_tiles(layer, tiles.opaque_tiles, tiles.opaque_texture, -layer.offsetX,
+              drawY, opaqueVertices);
+    add_tiles(layer, tiles.blend_tiles, tiles.blend_texture, -layer.offsetX,
+              drawY, blendVertices);
+    submit(renderer, tiles.opaque_texture, opaqueVertices);
+    submit(renderer, tiles.blend_texture, blendVertices);
   }
+  SDL_SetRenderDrawColor(renderer, r, g, b, a);
 }
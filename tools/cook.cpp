@@ -0,0 +1,39 @@
+#include <SDL3/SDL.h>
+#include <cstdlib>
+#include <cstring>
+
+#include "pack.h"
+#include "tilemap.h"
+
+// Offline asset cooking: turns editor exports into the formats the game
+// streams at runtime.
+static void print_usage(const char *exe) {
+  SDL_Log("usage: %s map IN.tmj OUT.slmap [--chunk TILES]", exe);
+  SDL_Log("  map    cook a Tiled JSON map into streamable chunks of");
+  SDL_Log("         TILES x TILES tiles (default %d)", TILEMAP_DEFAULT_CHUNK);
+  SDL_Log("       %s pack OUT.slpak FILE...", exe);
+  SDL_Log("  pack   bundle assets into one mappable file; PNGs are stored");
+  SDL_Log("         decoded, everything else as is. Run it from the game's");
+  SDL_Log("         directory so entries keep the paths the game opens.");
+}
+
+int main(int argc, char **argv) {
+  if (argc >= 4 && strcmp(argv[1], "map") == 0) {
+    int chunk = TILEMAP_DEFAULT_CHUNK;
+    for (int i = 4; i < argc; ++i) {
+      if (strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) {
+        chunk = atoi(argv[++i]);
+      } else {
+        print_usage(argv[0]);
+        return 1;
+      }
+    }
+    return cook_tiled_map(argv[2], argv[3], chunk) ? 0 : 1;
+  }
+
+  if (argc >= 4 && strcmp(argv[1], "pack") == 0)
+    return cook_asset_pack(argv[2], argv + 3, argc - 3) ? 0 : 1;
+
+  print_usage(argv[0]);
+  return 1;
+}